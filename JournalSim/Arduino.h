@@ -0,0 +1,15 @@
+#pragma once
+/* Just enough of Arduino.h for ../WWVBclock/Journal.cpp on the host */
+#include <stdint.h>
+#include <iostream>
+
+#define F(s) (s)
+
+struct HostSerial {
+    template <typename T> void print(const T &v) { std::cout << v; }
+    void print(uint8_t v) { std::cout << static_cast<unsigned>(v); }
+    void print(char c) { std::cout << c; }
+    template <typename T> void println(const T &v) { print(v); std::cout << std::endl; }
+    void println() { std::cout << std::endl; }
+};
+extern HostSerial Serial;
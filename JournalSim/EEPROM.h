@@ -0,0 +1,42 @@
+#pragma once
+/* An array in place of the Teensy 4 EEPROM, for ../WWVBclock/Journal.cpp on the host.
+** Like the Teensy's, a write of the value a byte already holds is not a write.
+** It counts the writes to each byte, and can lose power partway through a put(). */
+#include <stdint.h>
+#include <string.h>
+
+#define E2END 0x437 // Teensy 4.0: 1080 bytes
+
+struct EEPROMClass {
+    uint8_t bytes[E2END + 1];
+    uint32_t writes[E2END + 1];
+    long powerFailsAfter; // bytes still written before power fails. negative for never
+
+    EEPROMClass() : powerFailsAfter(-1) { memset(bytes, 0xFF, sizeof(bytes)); memset(writes, 0, sizeof(writes)); }
+
+    uint8_t read(int address) const { return bytes[address]; }
+    void write(int address, uint8_t v)
+    {
+        if (powerFailsAfter == 0)
+            return;
+        if (powerFailsAfter > 0)
+            powerFailsAfter -= 1;
+        if (bytes[address] == v)
+            return;
+        bytes[address] = v;
+        writes[address] += 1;
+    }
+    template <typename T> T &get(int address, T &t) const
+    {
+        memcpy(&t, bytes + address, sizeof(T));
+        return t;
+    }
+    template <typename T> const T &put(int address, const T &t)
+    {
+        auto p = reinterpret_cast<const uint8_t *>(&t);
+        for (unsigned i = 0; i < sizeof(T); i++)
+            write(address + i, p[i]);
+        return t;
+    }
+};
+extern EEPROMClass EEPROM;
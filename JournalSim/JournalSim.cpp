@@ -0,0 +1,169 @@
+/* JournalSim runs ../WWVBclock/Journal.cpp over the array in place of EEPROM in
+** EEPROM.h here, and replays years of the writes the sketch makes to it:
+**      each WWVB sync writes LastSyncUtc, DriftErrorSeconds and DriftIntervalSeconds
+**      each DST change writes DstInEffect
+**      each rain gauge report, and each local midnight after rain, writes the rain totals
+** Every so often the power fails partway through a write. The simulation then
+** runs setup() on a new Journal, as at power up, and checks every key came back
+** with either the value it had or the one being written.
+**
+** At the end it reports the writes to the busiest EEPROM byte, which is what
+** wears out, against the journal's size.
+**
+** Normal usage would be:
+**  JournalSim                      ten years, defaults below
+**  JournalSim 10 24 400 150 20     years, syncs a day, journal bytes, rain days a year, reports per rain day
+** The exit status is the count of failures, up to 255.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "../WWVBclock/Journal.h"
+
+HostSerial Serial;
+EEPROMClass EEPROM;
+
+namespace {
+    std::mt19937 rng(1);
+    unsigned failures = 0;
+    unsigned powerFailures = 0;
+
+    unsigned uniform(unsigned n) { return std::uniform_int_distribution<unsigned>(0, n - 1)(rng); }
+
+    struct Clock {
+        Clock(uint16_t start, uint16_t end) : start(start), end(end), journal(new Journal())
+        {
+            journal->setup(start, end);
+            for (uint8_t k = 0; k < Journal::NUM_KEYS; k++)
+                expected[k] = journal->value(static_cast<Journal::Key_t>(k));
+        }
+
+        /* One write, as the sketch makes it. One time in failEvery the power
+        ** fails partway through, and the clock powers back up */
+        void write(Journal::Key_t key, int32_t value, unsigned failEvery)
+        {
+            bool fail = failEvery != 0 && uniform(failEvery) == 0;
+            if (fail)
+                EEPROM.powerFailsAfter = static_cast<long>(uniform(16)); // within two records
+            journal->write(key, value);
+            if (fail && EEPROM.powerFailsAfter != 0)
+            {   // finished before the power failed
+                EEPROM.powerFailsAfter = -1;
+                fail = false;
+            }
+            if (!fail)
+            {
+                expected[key] = value;
+                has[key] = true;
+                return;
+            }
+            powerFailures += 1;
+            EEPROM.powerFailsAfter = -1;
+            journal.reset(new Journal());
+            journal->setup(start, end);
+            for (uint8_t k = 0; k < Journal::NUM_KEYS; k++)
+            {
+                auto jk = static_cast<Journal::Key_t>(k);
+                bool ok = !has[k] || (journal->has(jk) &&
+                    (journal->value(jk) == expected[k] || (k == key && journal->value(jk) == value)));
+                if (!ok && failures++ < 20)
+                    std::cout << "FAIL key " << static_cast<int>(k) << " lost after power failure, expected "
+                        << expected[k] << std::endl;
+                if (journal->has(jk))
+                {
+                    expected[k] = journal->value(jk);
+                    has[k] = true;
+                }
+            }
+        }
+
+        uint16_t start;
+        uint16_t end;
+        std::unique_ptr<Journal> journal;
+        int32_t expected[Journal::NUM_KEYS] = {};
+        bool has[Journal::NUM_KEYS] = {};
+    };
+}
+
+int main(int argc, char **argv)
+{
+    unsigned years = argc > 1 ? static_cast<unsigned>(atoi(argv[1])) : 10;
+    unsigned syncsPerDay = argc > 2 ? static_cast<unsigned>(atoi(argv[2])) : 24; // the ES100 is off an hour after each
+    unsigned journalBytes = argc > 3 ? static_cast<unsigned>(atoi(argv[3])) : 400; // what E2END leaves after settings and SensorRegistry
+    unsigned rainDays = argc > 4 ? static_cast<unsigned>(atoi(argv[4])) : 150;
+    unsigned reportsPerRainDay = argc > 5 ? static_cast<unsigned>(atoi(argv[5])) : 20;
+    const unsigned FAIL_EVERY = 500; // writes, on average
+
+    if (journalBytes > E2END + 1u)
+        journalBytes = E2END + 1u;
+    const uint16_t start = static_cast<uint16_t>(E2END + 1 - journalBytes);
+    Clock clock(start, E2END + 1);
+
+    const int32_t DAY = 24 * 60 * 60;
+    int32_t utc = 1700000000;
+    int32_t driftError = 0;
+    int32_t driftInterval = 0;
+    int32_t rainToday = 0;
+    int32_t rainYesterday = 0;
+    uint8_t dst = 0;
+    uint32_t writes = 0;
+
+    for (unsigned day = 0; day < years * 365u; day++, utc += DAY)
+    {
+        // local midnight
+        if (rainToday != 0 || rainYesterday != 0)
+        {
+            rainYesterday = rainToday;
+            rainToday = 0;
+            clock.write(Journal::RAIN_TODAY, rainToday, FAIL_EVERY);
+            clock.write(Journal::RAIN_YESTERDAY, rainYesterday, FAIL_EVERY);
+            clock.write(Journal::RAIN_UTC, utc, FAIL_EVERY);
+            writes += 3;
+        }
+        for (unsigned s = 0; s < syncsPerDay; s++)
+        {
+            auto syncUtc = utc + static_cast<int32_t>(s * DAY / syncsPerDay);
+            driftError += static_cast<int32_t>(uniform(3)) - 1;
+            driftInterval = syncUtc - utc + DAY;
+            clock.write(Journal::LAST_SYNC_UTC, syncUtc, FAIL_EVERY);
+            clock.write(Journal::DRIFT_ERROR_SECONDS, driftError, FAIL_EVERY);
+            clock.write(Journal::DRIFT_INTERVAL_SECONDS, driftInterval, FAIL_EVERY);
+            writes += 3;
+        }
+        if (day % 365 == 70 || day % 365 == 308)
+        {
+            dst ^= 1;
+            clock.write(Journal::DST_IN_EFFECT, dst, FAIL_EVERY);
+            writes += 1;
+        }
+        if (uniform(365) < rainDays)
+        {
+            for (unsigned r = 0; r < reportsPerRainDay; r++)
+            {
+                rainToday += 25;
+                clock.write(Journal::RAIN_TODAY, rainToday, FAIL_EVERY);
+                clock.write(Journal::RAIN_YESTERDAY, rainYesterday, FAIL_EVERY);
+                clock.write(Journal::RAIN_UTC, utc + static_cast<int32_t>(r * 60), FAIL_EVERY);
+                writes += 3;
+            }
+        }
+    }
+
+    auto busiest = std::max_element(EEPROM.writes + start, EEPROM.writes + E2END + 1);
+    uint64_t total = 0;
+    for (auto p = EEPROM.writes + start; p <= EEPROM.writes + E2END; p++)
+        total += *p;
+    std::cout << years << " years, " << journalBytes << " journal bytes, " << syncsPerDay << " syncs a day, "
+        << rainDays << " rain days a year of " << reportsPerRainDay << " reports" << std::endl
+        << writes << " Journal::write calls, " << powerFailures << " power failures, " << failures << " keys lost" << std::endl
+        << "busiest byte: " << *busiest << " writes at offset " << (busiest - EEPROM.writes - start)
+        << ", mean " << std::fixed << std::setprecision(0) << static_cast<double>(total) / journalBytes << std::endl;
+    clock.journal->print();
+    return failures > 255 ? 255 : static_cast<int>(failures);
+}
@@ -0,0 +1,289 @@
+/* SensorPayloadFuzz checks and times the weather sensor packet parser in
+** ../WWVBclock/SensorPayload.h, which this program shares with the sketch.
+**
+** The fuzz pass feeds it three kinds of packets:
+**      well formed, from random values, and checks every field parses to the value sent
+**      well formed but with values too long for int32_t hundredths, and checks they are rejected
+**      mutations of those, and random bytes, and checks nothing parses out of range
+** Each packet is in its own buffer of exactly its length, so building with
+** AddressSanitizer (/fsanitize=address, or -fsanitize=address) catches any read past its end.
+**
+** The benchmark pass times parsing a set of typical thermometer and raingauge packets,
+** against the parseForColon/atof and strstr/atoi path the sketch used before, copy included.
+**
+** Normal usage would be:
+**  SensorPayloadFuzz                   one million fuzz packets, seed 1
+**  SensorPayloadFuzz 10000000 42       ten million, seed 42
+** The exit status is the count of failures, up to 255.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include "../WWVBclock/SensorPayload.h"
+
+namespace {
+    const char * const KEY_NAMES[SensorPayload::NUM_KEYS] = { "C", "B", "T", "R", "F", "RG" };
+    const int32_t MAX_X100 = 999999999; // MAX_INTEGER_DIGITS nines, and two more
+
+    std::mt19937 rng;
+    unsigned failures = 0;
+
+    unsigned uniform(unsigned n) { return std::uniform_int_distribution<unsigned>(0, n - 1)(rng); }
+
+    void fail(const std::string &what, const std::vector<uint8_t> &packet)
+    {
+        if (failures++ < 20)
+        {
+            std::cout << "FAIL " << what << " packet='";
+            for (auto c : packet)
+            {
+                if (c >= ' ' && c < 0x7F)
+                    std::cout << static_cast<char>(c);
+                else
+                    std::cout << "\\x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            }
+            std::cout << "'" << std::endl;
+        }
+    }
+
+    SensorPayload parse(const std::vector<uint8_t> &packet)
+    {   // exactly its length, for the sanitizer
+        std::unique_ptr<uint8_t[]> buf(new uint8_t[packet.size() ? packet.size() : 1]);
+        if (!packet.empty())
+            memcpy(buf.get(), packet.data(), packet.size());
+        SensorPayload f;
+        f.parse(buf.get(), static_cast<uint8_t>(packet.size()));
+        return f;
+    }
+
+    // a value as the sensors format it, with 0 to 3 decimals and an optional sign
+    std::string format(int32_t x100, unsigned decimals, bool plus, int32_t &expected)
+    {
+        char buf[32];
+        auto mag = x100 < 0 ? -static_cast<int64_t>(x100) : x100;
+        const char *sign = x100 < 0 ? "-" : (plus ? "+" : "");
+        switch (decimals)
+        {
+            case 0:
+                snprintf(buf, sizeof(buf), "%s%lld", sign, static_cast<long long>(mag / 100));
+                mag -= mag % 100;
+                break;
+            case 1:
+                snprintf(buf, sizeof(buf), "%s%lld.%lld", sign, static_cast<long long>(mag / 100), static_cast<long long>(mag % 100 / 10));
+                mag -= mag % 10;
+                break;
+            case 2:
+                snprintf(buf, sizeof(buf), "%s%lld.%02lld", sign, static_cast<long long>(mag / 100), static_cast<long long>(mag % 100));
+                break;
+            default: // the third decimal is ignored
+                snprintf(buf, sizeof(buf), "%s%lld.%02lld%u", sign, static_cast<long long>(mag / 100), static_cast<long long>(mag % 100), uniform(10));
+                break;
+        }
+        expected = static_cast<int32_t>(x100 < 0 ? -mag : mag);
+        return buf;
+    }
+
+    std::vector<uint8_t> wellFormed(int32_t expected[SensorPayload::NUM_KEYS], uint8_t &present)
+    {
+        std::string s;
+        present = 0;
+        for (unsigned k = 0; k < SensorPayload::NUM_KEYS; k++)
+        {
+            if (uniform(3) == 0)
+                continue;
+            int32_t x100 = static_cast<int32_t>(uniform(MAX_X100 + 1u));
+            if (uniform(4) != 0)
+                x100 /= 10000; // mostly typical sizes
+            if (uniform(2))
+                x100 = -x100;
+            if (!s.empty())
+                s += uniform(2) ? ", " : " ";
+            s += KEY_NAMES[k];
+            s += ':';
+            if (uniform(2))
+                s += ' ';
+            s += format(x100, uniform(4), uniform(2) != 0, expected[k]);
+            present |= 1 << k;
+        }
+        if (uniform(2))
+            s += '\0'; // the sensors send the terminator
+        return std::vector<uint8_t>(s.begin(), s.end());
+    }
+
+    void fuzzWellFormed()
+    {
+        int32_t expected[SensorPayload::NUM_KEYS];
+        uint8_t present;
+        auto packet = wellFormed(expected, present);
+        if (packet.size() > 0xFF)
+            return;
+        auto f = parse(packet);
+        if (f.present != present)
+            fail("present mismatch", packet);
+        for (unsigned k = 0; k < SensorPayload::NUM_KEYS; k++)
+            if ((present & (1 << k)) && f.x100[k] != expected[k])
+                fail(std::string("value of ") + KEY_NAMES[k] + " " + std::to_string(f.x100[k]) + " expected " + std::to_string(expected[k]), packet);
+    }
+
+    void fuzzOverflow()
+    {
+        std::string s = "T:";
+        if (uniform(2))
+            s += '-';
+        s += static_cast<char>('1' + uniform(9));
+        auto digits = SensorPayload::MAX_INTEGER_DIGITS + uniform(60); // past the integer digit limit
+        for (unsigned i = 0; i < digits; i++)
+            s += static_cast<char>('0' + uniform(10));
+        if (uniform(2))
+            s += ".37";
+        s += " B:244";
+        std::vector<uint8_t> packet(s.begin(), s.end());
+        auto f = parse(packet);
+        if (f.has(SensorPayload::T))
+            fail("overflow accepted", packet);
+        if (!f.has(SensorPayload::B) || f.x100[SensorPayload::B] != 24400)
+            fail("field after overflow lost", packet);
+    }
+
+    void fuzzMutated()
+    {
+        std::vector<uint8_t> packet;
+        if (uniform(4) == 0)
+        {
+            packet.resize(uniform(0x100));
+            for (auto &c : packet)
+                c = static_cast<uint8_t>(uniform(0x100));
+        }
+        else
+        {
+            int32_t expected[SensorPayload::NUM_KEYS];
+            uint8_t present;
+            packet = wellFormed(expected, present);
+            auto edits = 1 + uniform(4);
+            static const char ALPHABET[] = "CBTRFG:.+- 0123456789\0";
+            for (unsigned i = 0; i < edits && !packet.empty(); i++)
+            {
+                auto at = uniform(static_cast<unsigned>(packet.size()));
+                switch (uniform(4))
+                {
+                    case 0: packet[at] = static_cast<uint8_t>(uniform(0x100)); break;
+                    case 1: packet[at] = ALPHABET[uniform(sizeof(ALPHABET) - 1)]; break;
+                    case 2: packet.erase(packet.begin() + at); break;
+                    case 3: packet.resize(at); break;
+                }
+            }
+        }
+        if (packet.size() > 0xFF)
+            packet.resize(0xFF);
+        auto f = parse(packet);
+        for (unsigned k = 0; k < SensorPayload::NUM_KEYS; k++)
+            if (f.has(static_cast<SensorPayload::Key_t>(k)) && (f.x100[k] > MAX_X100 || f.x100[k] < -MAX_X100))
+                fail(std::string("out of range ") + KEY_NAMES[k], packet);
+    }
+
+    // The parse the sketch used before SensorPayload, for the benchmark
+    const float NO_DATA = -999.9f;
+    char reportbuf[62]; // sizeof(RFM69::DATA) + 1
+
+    float parseForColon(char flag, const char* p, uint8_t len)
+    {   // help parse the Wireless Thermometer packet
+        uint8_t c = len;
+        for (;;)
+        {
+            if (!*p)
+                return NO_DATA;
+            if (c == 0)
+                return NO_DATA;
+            if (p[0] == flag && p[1] == ':')
+            {
+                p += 2;  c -= 2;
+                return static_cast<float>(atof(p));
+            } else
+            {
+                p += 1;
+                c -= 1;
+            }
+        }
+    }
+
+    int32_t oldPath(const uint8_t *data, uint8_t len, bool raingauge)
+    {
+        memset(reportbuf, 0, sizeof(reportbuf));
+        memcpy(reportbuf, data, len < sizeof(reportbuf) - 1 ? len : sizeof(reportbuf) - 1);
+        if (!raingauge)
+            return static_cast<int32_t>(parseForColon('T', reportbuf, len) * 100);
+        const char *isF = strstr(reportbuf, " F: ");
+        const char *isRG = strstr(reportbuf, " RG: ");
+        if (isF == 0 || isRG == 0)
+            return 0;
+        return atoi(isRG + 5) + atoi(isF + 4);
+    }
+
+    int32_t newPath(const uint8_t *data, uint8_t len, bool raingauge)
+    {
+        SensorPayload f;
+        f.parse(data, len);
+        if (!raingauge)
+            return f.has(SensorPayload::T) ? f.x100[SensorPayload::T] : 0;
+        if (!f.has(SensorPayload::F) || !f.has(SensorPayload::RG))
+            return 0;
+        return f.integer(SensorPayload::RG) + f.integer(SensorPayload::F);
+    }
+
+    template <typename Parse>
+    double packetsPerSecond(Parse parse, unsigned repeat, volatile int32_t &sink)
+    {
+        static const struct { const char *text; bool raingauge; } PACKETS[] = {
+            { "C:49433, B:244, T:+20.37", false },
+            { "C:1769, B:198, T:+20.58 R:45.46", false },
+            { "C:112, B:201, F: -1234 RG: 1", true },
+            { "C:113, B:201, F: 2211 RG: 0", true },
+            { "C:49434, B:243, T:-3.06", false },
+        };
+        const unsigned N = sizeof(PACKETS) / sizeof(PACKETS[0]);
+        auto begin = std::chrono::steady_clock::now();
+        for (unsigned r = 0; r < repeat; r++)
+            for (unsigned i = 0; i < N; i++)
+                sink = sink + parse(reinterpret_cast<const uint8_t *>(PACKETS[i].text),
+                        static_cast<uint8_t>(strlen(PACKETS[i].text) + 1), PACKETS[i].raingauge);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        return repeat * N / elapsed.count();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long iterations = argc > 1 ? strtoul(argv[1], 0, 10) : 1000000ul;
+    unsigned seed = argc > 2 ? static_cast<unsigned>(strtoul(argv[2], 0, 10)) : 1u;
+    rng.seed(seed);
+
+    for (unsigned long i = 0; i < iterations; i++)
+    {
+        switch (i % 3)
+        {
+            case 0: fuzzWellFormed(); break;
+            case 1: fuzzOverflow(); break;
+            case 2: fuzzMutated(); break;
+        }
+    }
+    std::cout << "fuzz: " << iterations << " packets, seed " << seed << ", " << failures << " failures" << std::endl;
+
+    volatile int32_t sink = 0;
+    const unsigned REPEAT = 200000;
+    auto before = packetsPerSecond(oldPath, REPEAT, sink);
+    auto after = packetsPerSecond(newPath, REPEAT, sink);
+    std::cout << std::fixed << std::setprecision(0)
+        << "parseForColon/atof: " << before << " packets/sec" << std::endl
+        << "SensorPayload:      " << after << " packets/sec" << std::endl
+        << std::setprecision(1) << "ratio: " << after / before << std::endl;
+
+    return failures > 255 ? 255 : static_cast<int>(failures);
+}
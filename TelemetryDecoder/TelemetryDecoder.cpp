@@ -0,0 +1,159 @@
+/* TelemetryDecoder for the status frames WWVBclock sends to its gateway.
+** See the Telemetry= command in WWVBclock.ino, and the frame layout in
+** ../WWVBclock/TelemetryFrame.h, which this program shares with the sketch.
+**
+** Input is the gateway's log, one received frame per line, as hex bytes.
+** The sending node ID, when the log has one, comes before a colon:
+**      12: A5 01 01 01 07 ...
+**      A50101010...
+** Lines that are not telemetry frames are ignored.
+**
+** Normal usage would be:
+**  TelemetryDecoder < gateway.log
+**  TelemetryDecoder gateway.log
+** Each frame prints one line. At the end is a table of the latest frame from
+** each clock, so a whole fleet can be checked at once.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <iomanip>
+#include <ctime>
+#include <cctype>
+#include "../WWVBclock/TelemetryFrame.h"
+
+namespace {
+    struct Clock {
+        TelemetryFrame::Status latest;
+        unsigned frames = 0;
+        unsigned missed = 0; // sequence numbers skipped
+    };
+
+    int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        if (c >= 'A' && c <= 'F') return 10 + c - 'A';
+        return -1;
+    }
+
+    // returns false if the line has anything but hex bytes after the optional node prefix
+    bool parseLine(const std::string &line, int &node, std::vector<uint8_t> &bytes)
+    {
+        node = -1;
+        bytes.clear();
+        std::string::size_type pos = 0;
+        auto colon = line.find(':');
+        if (colon != std::string::npos)
+        {
+            try { node = std::stoi(line.substr(0, colon)); }
+            catch (...) { return false; }
+            pos = colon + 1;
+        }
+        int high = -1;
+        for (; pos < line.size(); pos++)
+        {
+            char c = line[pos];
+            if (std::isspace(static_cast<unsigned char>(c)) || c == ',')
+                continue;
+            if (c == '0' && pos + 1 < line.size() && (line[pos + 1] == 'x' || line[pos + 1] == 'X') && high < 0)
+            {
+                pos += 1;
+                continue;
+            }
+            int v = hexValue(c);
+            if (v < 0)
+                return false;
+            if (high < 0)
+                high = v;
+            else
+            {
+                bytes.push_back(static_cast<uint8_t>(high * 16 + v));
+                high = -1;
+            }
+        }
+        return high < 0 && !bytes.empty();
+    }
+
+    std::string utcString(uint32_t t)
+    {
+        if (t == 0)
+            return "never";
+        std::time_t tt = t;
+        std::tm tm = {};
+#if defined(_WIN32)
+        gmtime_s(&tm, &tt);
+#else
+        gmtime_r(&tt, &tm);
+#endif
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%SZ", &tm);
+        return buf;
+    }
+
+    void print(std::ostream &os, int node, const TelemetryFrame::Status &s)
+    {
+        os << "node " << std::setw(3) << node
+            << " v" << static_cast<int>(s.firmwareMajor) << "." << static_cast<int>(s.firmwareMinor)
+            << " seq " << std::setw(3) << static_cast<int>(s.sequence)
+            << " up " << s.uptimeSeconds / 3600 << "h"
+            << " sync " << utcString(s.lastSyncUtc)
+            << " " << s.syncs << "/" << s.searches;
+        if (s.searches)
+            os << " (" << std::fixed << std::setprecision(0) << 100.0 * s.syncs / s.searches << "%)";
+        os << " drift " << std::fixed << std::setprecision(1) << s.driftTenthsPpm / 10.0 << "ppm"
+            << " loop max " << s.loopMaxMsec << "ms"
+            << " rx dropped " << s.rxDropped
+            << " noise " << static_cast<int>(s.noiseFloorDbm) << "dBm"
+            << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::ifstream file;
+    if (argc > 1)
+    {
+        file.open(argv[1]);
+        if (!file.is_open())
+        {
+            std::cerr << "Cannot open " << argv[1] << std::endl;
+            return 1;
+        }
+    }
+    std::istream &in = argc > 1 ? file : std::cin;
+
+    std::map<int, Clock> fleet;
+    std::string line;
+    std::vector<uint8_t> bytes;
+    while (std::getline(in, line))
+    {
+        int node;
+        TelemetryFrame::Status s;
+        if (!parseLine(line, node, bytes) ||
+            !TelemetryFrame::decode(bytes.data(), static_cast<unsigned>(bytes.size()), s))
+            continue;
+        auto &clock = fleet[node];
+        if (clock.frames > 0)
+        {
+            uint8_t expected = static_cast<uint8_t>(clock.latest.sequence + 1);
+            // a restarted clock starts again at sequence zero
+            if (s.uptimeSeconds >= clock.latest.uptimeSeconds)
+                clock.missed += static_cast<uint8_t>(s.sequence - expected);
+        }
+        clock.latest = s;
+        clock.frames += 1;
+        print(std::cout, node, s);
+    }
+
+    std::cout << std::endl << "Fleet: " << fleet.size() << " clocks" << std::endl;
+    for (const auto &c : fleet)
+    {
+        print(std::cout, c.first, c.second.latest);
+        std::cout << "         frames " << c.second.frames << " missed " << c.second.missed << std::endl;
+    }
+    return 0;
+}
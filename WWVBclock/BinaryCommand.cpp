@@ -0,0 +1,40 @@
+#include "BinaryCommand.h"
+
+namespace BinaryCommand {
+
+uint8_t dispatch(const Entry *table, Apply_t apply, const uint8_t *frame, uint8_t len, uint8_t *reply, uint8_t replyMax)
+{
+    if (len < HEADER_BYTES || frame[0] != MAGIC || replyMax <= REPLY_HEADER_BYTES)
+        return 0;
+    reply[0] = REPLY_MAGIC;
+    reply[1] = frame[1];
+    uint8_t count = 0;
+    uint8_t *results = reply + REPLY_HEADER_BYTES;
+    const uint8_t maxResults = replyMax - REPLY_HEADER_BYTES;
+    for (uint8_t pos = HEADER_BYTES; pos < len && count < maxResults; )
+    {
+        uint8_t op = frame[pos++];
+        if (op >= NUM_OPCODES || table[op].command == NO_COMMAND)
+        {
+            results[count++] = RESULT_UNKNOWN_OPCODE;
+            break;
+        }
+        const auto &e = table[op];
+        uint8_t n = argBytes(e.type);
+        if (pos + n > len)
+        {
+            results[count++] = RESULT_TRUNCATED;
+            break;
+        }
+        uint32_t v = 0;
+        for (uint8_t i = 0; i < n; i++)
+            v |= static_cast<uint32_t>(frame[pos + i]) << (8 * i);
+        pos += n;
+        int32_t arg = e.type == ARG_I16 ? static_cast<int16_t>(v) : static_cast<int32_t>(v);
+        results[count++] = apply(e.command, arg) ? RESULT_OK : RESULT_BAD_ARGUMENT;
+    }
+    reply[2] = count;
+    return REPLY_HEADER_BYTES + count;
+}
+
+}
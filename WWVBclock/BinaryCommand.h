@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+
+/* Binary commands over the packet radio, accepted alongside the text commands.
+** This header uses nothing from Arduino, so a gateway can share it.
+**
+** command frame:   MAGIC, sequence, then opcode and argument, opcode and argument...
+**                  to the end of the frame. Arguments are little endian, sized by the opcode.
+** reply:           REPLY_MAGIC, sequence, count, then one Result_t per command processed.
+**
+** Several settings fit in one 61 byte frame. Processing stops at the first opcode
+** that is unknown or whose argument is cut off by the end of the frame, because
+** the rest of the frame can't be parsed after it.
+** Opcode values are sent over the air. Never renumber them. Add new ones at the end.
+*/
+namespace BinaryCommand {
+    const uint8_t MAGIC = 0xC3; // not ASCII, so never the start of a text command
+    const uint8_t REPLY_MAGIC = 0xC4;
+    const uint8_t HEADER_BYTES = 2;
+    const uint8_t REPLY_HEADER_BYTES = 3;
+
+    enum Opcode_t : uint8_t {
+        OP_NONE,
+        OP_TIME_ZONE_OFFSET,    // int16 minutes
+        OP_OBSERVE_DST,         // uint8
+        OP_LED_CURRENT,         // uint8 0-3
+        OP_LED_PWM,             // uint8 0-15
+        OP_DST_IS_IN_EFFECT,    // uint8
+        OP_TIME,                // uint32 UTC
+        OP_ROTATE_LED_180,      // uint8
+        OP_INDOOR_THERMOMETER_MASK, // uint32
+        OP_OUTDOOR_THERMOMETER_MASK,// uint32
+        OP_RAINGAUGE_MASK,      // uint32
+        OP_METRIC_UNITS,        // uint8
+        OP_12HOUR_DISPLAY,      // uint8
+        OP_ES100_ENABLE,        // uint8
+        OP_TIME_DISPLAY_FONT,   // uint8
+        OP_USE_FLIPPED_FONTS,   // uint8
+        OP_HCMS290X_ENABLE,     // uint8
+        OP_TRY_RADIO_SILENCE,   // uint8
+        OP_STARTUP_DELAY_SECONDS, // uint8
+        OP_RAINGAUGE_CORRECT,   // int16 per thousand
+        OP_BEGIN_RADIO_SILENCE, // no argument
+        OP_END_RADIO_SILENCE,   // no argument
+        OP_CPU_GOVERNOR,        // uint8
+        OP_RADIO_QUIET,         // uint8
+        OP_TELEMETRY,           // uint16 seconds
+        NUM_OPCODES
+    };
+
+    enum ArgType_t : uint8_t {ARG_NONE, ARG_U8, ARG_I16, ARG_U16, ARG_U32};
+
+    enum Result_t : uint8_t {RESULT_OK, RESULT_UNKNOWN_OPCODE, RESULT_BAD_ARGUMENT, RESULT_TRUNCATED};
+
+    const uint8_t NO_COMMAND = 0xFF;
+    struct Entry {
+        ArgType_t type;
+        uint8_t command; // passed to Apply_t. NO_COMMAND if the opcode is unknown
+    };
+    typedef bool (*Apply_t)(uint8_t command, int32_t arg);
+
+    inline uint8_t argBytes(ArgType_t t)
+    {
+        return t == ARG_U32 ? 4 : (t == ARG_NONE ? 0 : (t == ARG_U8 ? 1 : 2));
+    }
+
+    /* table is indexed by opcode, NUM_OPCODES entries. apply is called once per command.
+    ** reply must hold replyMax bytes. Returns the length of the reply, or zero if frame isn't a command. */
+    uint8_t dispatch(const Entry *table, Apply_t apply, const uint8_t *frame, uint8_t len, uint8_t *reply, uint8_t replyMax);
+}
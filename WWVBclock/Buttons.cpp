@@ -0,0 +1,82 @@
+#include <Arduino.h>
+#include "Buttons.h"
+
+Buttons *Buttons::s_self;
+
+Buttons::Buttons(uint8_t sw1Pin, uint8_t sw2Pin)
+    : m_switch{ {sw1Pin, false, 0}, {sw2Pin, false, 0} }
+    , m_edges()
+    , m_head(0)
+    , m_tail(0)
+    , m_dropped(0)
+{}
+
+void Buttons::setup()
+{
+    s_self = this;
+    for (auto &s : m_switch)
+    {
+        pinMode(s.pin, INPUT_PULLUP);
+        s.pressed = digitalReadFast(s.pin) == LOW;
+        s.edgeUsec = micros();
+    }
+    attachInterrupt(digitalPinToInterrupt(m_switch[SW1].pin), &Buttons::isrSw1, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(m_switch[SW2].pin), &Buttons::isrSw2, CHANGE);
+}
+
+void Buttons::isrSw1()
+{
+    s_self->onEdge(SW1, micros(), digitalReadFast(s_self->m_switch[SW1].pin) == LOW);
+}
+
+void Buttons::isrSw2()
+{
+    s_self->onEdge(SW2, micros(), digitalReadFast(s_self->m_switch[SW2].pin) == LOW);
+}
+
+void Buttons::onEdge(Button_t b, uint32_t usec, bool pressed)
+{   // interrupts are off
+    auto &s = m_switch[b];
+    if (pressed == s.pressed || usec - s.edgeUsec < DEBOUNCE_USEC)
+        return; // bounce
+    s.pressed = pressed;
+    s.edgeUsec = usec;
+    if (static_cast<uint8_t>(m_head - m_tail) >= QUEUE_LENGTH)
+    {
+        m_dropped += 1;
+        return;
+    }
+    auto &e = m_edges[m_head & (QUEUE_LENGTH - 1)];
+    e.button = b;
+    e.pressed = pressed;
+    e.usec = usec;
+    m_head += 1;
+}
+
+void Buttons::settle(Button_t b)
+{   // an edge during the lockout might have been the last one
+    noInterrupts();
+    onEdge(b, micros(), digitalReadFast(m_switch[b].pin) == LOW);
+    interrupts();
+}
+
+bool Buttons::pop(Event &e)
+{
+    if (m_head == m_tail)
+    {
+        settle(SW1);
+        settle(SW2);
+        if (m_head == m_tail)
+            return false;
+    }
+    const auto &edge = m_edges[m_tail & (QUEUE_LENGTH - 1)];
+    e.button = edge.button;
+    e.pressed = edge.pressed;
+    noInterrupts();
+    auto ageUsec = micros() - edge.usec;
+    auto nowMsec = millis();
+    interrupts();
+    e.msec = nowMsec - ageUsec / 1000;
+    m_tail += 1;
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+/* Buttons watches SW1 and SW2 with pin change interrupts instead of loop()
+** sampling them. The ISR timestamps each edge with micros() and queues it, so
+** a click is never missed, and a hold is timed from when the switch actually
+** closed rather than from when loop() next came around.
+**
+** Debounce is in the ISR: the first edge is taken immediately and further
+** edges on that switch are ignored for DEBOUNCE_USEC. pop() then checks the pin
+** in case the contacts came to rest in the other state during the lockout.
+*/
+class Buttons {
+    public:
+        enum Button_t : uint8_t {SW1, SW2, NUM_BUTTONS};
+        enum {QUEUE_LENGTH = 16}; // must be power of 2
+        static const uint32_t DEBOUNCE_USEC = 20000;
+
+        struct Event {
+            Button_t button;
+            bool pressed; // false for released
+            unsigned long msec; // the edge, on the millis() clock
+        };
+
+        Buttons(uint8_t sw1Pin, uint8_t sw2Pin); // switches close to ground
+        void setup();
+        bool pop(Event &);
+        bool pending() const { return m_head != m_tail; }
+        bool pressed(Button_t b) const { return m_switch[b].pressed; }
+        uint32_t dropped() const { return m_dropped; }
+
+    protected:
+        struct Switch {
+            uint8_t pin;
+            volatile bool pressed;
+            volatile uint32_t edgeUsec;
+        };
+        struct Edge {
+            Button_t button;
+            bool pressed;
+            uint32_t usec;
+        };
+        static void isrSw1();
+        static void isrSw2();
+        void onEdge(Button_t, uint32_t usec, bool pressed);
+        void settle(Button_t);
+        static Buttons *s_self;
+        Switch m_switch[NUM_BUTTONS];
+        Edge m_edges[QUEUE_LENGTH];
+        volatile uint8_t m_head; // written only by ISR, or by settle() with interrupts off
+        volatile uint8_t m_tail; // written only by pop
+        volatile uint32_t m_dropped;
+};
@@ -15,6 +15,7 @@ ClockDisplay::ClockDisplay(LiquidCrystal &lcd, Hcms290xType_t &led)
     , lastDisplayedMinute(-1)
     , lastTimet(0)
     , radioSilence(false)
+    , m_quiet(false)
     , utcSecondsOffset(0)
     , DST(false)
     , m_DstScheduledBegin(false)
@@ -30,6 +31,7 @@ ClockDisplay::ClockDisplay(LiquidCrystal &lcd, Hcms290xType_t &led)
     , m_rainYesterday(0)
     , m_clearedRainToday(false)
     , m_rainGaugeCorrectionPerThousand(1000)
+    , m_lcdSecondLinePending(false)
 {
 }
 
@@ -64,6 +66,13 @@ void ClockDisplay::updateDisplay()
     lastTimet = 0;
 }
 
+void ClockDisplay::restoreDst(bool dst, bool scheduledBegin, time_t changesWhen)
+{
+    setDST(dst);
+    m_DstScheduledBegin = scheduledBegin;
+    m_DstChangesWhen = changesWhen;
+}
+
 void ClockDisplay::scheduleDSTchangeAt(bool begins, time_t utcMidnight, uint8_t localHour)
 {
     m_DstScheduledBegin = begins;
@@ -122,6 +131,15 @@ void ClockDisplay::setRadioSilence(bool v)
     radioSilence = v;
 }
 
+void ClockDisplay::setQuiet(bool v)
+{
+    if (v != m_quiet)
+    {
+        m_quiet = v;
+        updateDisplay();
+    }
+}
+
 static void printdig(Print &s, uint8_t d)
 {
     if (d < 10)
@@ -201,10 +219,16 @@ void ClockDisplay::displayRain(float rmm)
     }
 }
 
-void ClockDisplay::loop(bool ledEnabled, bool lcdEnabled)
+bool ClockDisplay::loop(bool ledEnabled, bool lcdEnabled)
 {
+    if (m_lcdSecondLinePending)
+    {   // the redraw yielded after the time
+        m_lcdSecondLinePending = false;
+        lcdSecondLine();
+        return false;
+    }
     if (radioSilence)
-        return;
+        return false;
 
     if (timeStatus() != timeSet)
     {
@@ -213,12 +237,12 @@ void ClockDisplay::loop(bool ledEnabled, bool lcdEnabled)
         static const char SET[Hcms290xType_t::DISPLAY_WIDTH] = {'S', 'e', 't', '!' };
         led.setCurrentFontIdx(HCMS_OEM_FONT_IDX);
         led.displayString(SET);       
-        return;
+        return false;
     }
 
     auto t = now();
     if (t == lastTimet)
-        return;
+        return false;
     lastTimet = t;
     m_Blink = static_cast<Blink_t>(static_cast<unsigned>(m_Blink)+1);
     if (static_cast<unsigned>(m_Blink) > static_cast<unsigned>(BLINK_4))
@@ -254,7 +278,7 @@ void ClockDisplay::loop(bool ledEnabled, bool lcdEnabled)
     if (m_12Hour)
         hr = hourFormat12(t);
     bool hrOrMinChanged = (min != lastDisplayedMinute) ||   (hr != lastDisplayedHour);
-    if (lcdEnabled)
+    if (lcdEnabled && (hrOrMinChanged || !m_quiet))
     {
         lcd.clear();
         if (m_12Hour)
@@ -267,54 +291,14 @@ void ClockDisplay::loop(bool ledEnabled, bool lcdEnabled)
             printdig(lcd, hr);
         lcd.print(':');
         printdig(lcd, min);
-        lcd.print(':');
-        printdig(lcd, sec);
-        if (m_outdoortempC != ABSENT_TEMP)
-        {
-            static const unsigned long t10_MINUTES_MSEC = 1000ul * 60u * 10u;
-            if (millis() - m_outdoortempTime < t10_MINUTES_MSEC)
-            {
-                char buf[8];
-                memset(buf,0,sizeof(buf));
-                lcd.setCursor(0,1);
-                auto t = m_outdoortempC;
-                if ((t < 99 && t > -40))
-                {
-                    if (!m_unitsInMetric)
-                    {
-                        t *= 9;
-                        t /= 5;
-                        t += 32;
-                        dtostrf(t, 3, 0, buf);
-                        buf[3] = 0xdf;
-                        lcd.print(buf);
-                    }
-                    else
-                    {
-                        dtostrf(t, 3, 0, buf);
-                        lcd.print(buf);
-                        float intpart;
-
-                        if (fabs(modf(t, &intpart)) >= 0.5)
-                            lcd.write(byte(0));
-                        lcd.write(byte(0xdf));
-                    }
-                }
-                else
-                    lcd.write('?');
-             }
-            else m_outdoortempC = ABSENT_TEMP;
+        if (!m_quiet)
+        {   // seconds would need an update every second
+            lcd.print(':');
+            printdig(lcd, sec);
         }
-        if (m_rainYesterday > 0 && ((m_Blink == BLINK_1) || (m_Blink==BLINK_2)))
-        {
-            lcd.setCursor(0,1);
-            lcd.print("Yst:");
-            displayRain(m_rainYesterday);
-        }
-        else if (m_rainToday > 0)
-            displayRain(m_rainToday);
+        m_lcdSecondLinePending = true;
     }
-    if (hrOrMinChanged || m_displayStyle == TimeDisplaySyle::SMALL_COLON)
+    if (hrOrMinChanged || (m_displayStyle == TimeDisplaySyle::SMALL_COLON && !m_quiet))
     {   // led doesn't show seconds
         if (ledEnabled)
         {
@@ -335,6 +319,55 @@ void ClockDisplay::loop(bool ledEnabled, bool lcdEnabled)
     }
     lastDisplayedMinute = min;
     lastDisplayedHour = hr;
+    return m_lcdSecondLinePending;
+}
+
+void ClockDisplay::lcdSecondLine()
+{   // outdoor temperature and rain
+    if (m_outdoortempC != ABSENT_TEMP)
+    {
+        static const unsigned long t10_MINUTES_MSEC = 1000ul * 60u * 10u;
+        if (millis() - m_outdoortempTime < t10_MINUTES_MSEC)
+        {
+            char buf[8];
+            memset(buf,0,sizeof(buf));
+            lcd.setCursor(0,1);
+            auto t = m_outdoortempC;
+            if ((t < 99 && t > -40))
+            {
+                if (!m_unitsInMetric)
+                {
+                    t *= 9;
+                    t /= 5;
+                    t += 32;
+                    dtostrf(t, 3, 0, buf);
+                    buf[3] = 0xdf;
+                    lcd.print(buf);
+                }
+                else
+                {
+                    dtostrf(t, 3, 0, buf);
+                    lcd.print(buf);
+                    float intpart;
+
+                    if (fabs(modf(t, &intpart)) >= 0.5)
+                        lcd.write(byte(0));
+                    lcd.write(byte(0xdf));
+                }
+            }
+            else
+                lcd.write('?');
+         }
+        else m_outdoortempC = ABSENT_TEMP;
+    }
+    if (m_rainYesterday > 0 && ((m_Blink == BLINK_1) || (m_Blink==BLINK_2)))
+    {
+        lcd.setCursor(0,1);
+        lcd.print("Yst:");
+        displayRain(m_rainYesterday);
+    }
+    else if (m_rainToday > 0)
+        displayRain(m_rainToday);
 }
 
 void ClockDisplay::ledDisplayAddColon(char *p) const
@@ -382,6 +415,31 @@ void ClockDisplay::notifyOutdoorTemp(float tempX10Cent)
 void ClockDisplay::notifyRainmm(float v)
 {    m_rainToday += v;}
 
+time_t ClockDisplay::localDay(time_t utc) const
+{
+    auto t = utc + utcSecondsOffset;
+    if (DST)
+        t += 3600;
+    return t / SECS_PER_DAY;
+}
+
+void ClockDisplay::restoreRain(float today, float yesterday, time_t utcWhen)
+{
+    auto t = now();
+    auto then = localDay(utcWhen);
+    auto day = localDay(t);
+    // loop() shows yesterday's rain only until noon
+    bool beforeNoon = localDay(t - SECS_PER_DAY / 2) != day;
+    if (then == day)
+    {
+        m_rainToday = today;
+        if (beforeNoon)
+            m_rainYesterday = yesterday;
+    }
+    else if (then + 1 == day && beforeNoon)
+        m_rainYesterday = today;
+}
+
 void ClockDisplay::unitsInMetric(bool v)
 {    m_unitsInMetric = v;}
 
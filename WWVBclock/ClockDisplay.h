@@ -13,8 +13,10 @@ class ClockDisplay : public ClockNotification
     public:
         ClockDisplay(LiquidCrystal &lcd, Hcms290xType_t &led);
         void setup();
-        void loop(bool ledEnabled, bool lcdEnabled);
+        // true when the LCD redraw yielded after the time. Call again to draw its second line
+        bool loop(bool ledEnabled, bool lcdEnabled);
         void setRadioSilence(bool); // The WWVB receiver might need us to shut down oscillators.
+        void setQuiet(bool); // update only once a minute while the WWVB receiver listens
         void printClock();
 
         enum class TimeDisplaySyle {OEM_FONT, SEG7_FONT, USE_DECIMAL, SMALL_COLON, DISPLAY_STYLE_MAX};
@@ -34,16 +36,30 @@ class ClockDisplay : public ClockNotification
         void notifyIndoorTemp(float) override;
         void notifyOutdoorTemp(float) override;
         void notifyRainmm(float) override;
+
+        // rain totals, for the Journal. Restored totals from an earlier local day age accordingly
+        float rainToday() const { return m_rainToday; }
+        float rainYesterday() const { return m_rainYesterday; }
+        void restoreRain(float today, float yesterday, time_t utcWhen);
+
+        // DST as displayed, and any change scheduled from WWVB. For a warm restart
+        bool dst() const { return DST; }
+        bool dstScheduledBegin() const { return m_DstScheduledBegin; }
+        time_t dstChangesWhen() const { return m_DstChangesWhen; }
+        void restoreDst(bool dst, bool scheduledBegin, time_t changesWhen);
        
     protected:
         void ledDisplayAddColon(char *) const;
         void displayRain(float mm);
+        void lcdSecondLine();
+        time_t localDay(time_t utc) const;
         LiquidCrystal &lcd;
         Hcms290xType_t &led;
         int lastDisplayedHour;
         int lastDisplayedMinute;
         time_t lastTimet;
         bool radioSilence;
+        bool m_quiet;
         int utcSecondsOffset;
         bool DST;
         bool m_DstScheduledBegin;
@@ -59,4 +75,5 @@ class ClockDisplay : public ClockNotification
         float m_rainYesterday;
         bool m_clearedRainToday;
         uint16_t m_rainGaugeCorrectionPerThousand;
+        bool m_lcdSecondLinePending;
 };
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include "ClockGovernor.h"
+#include "EventLog.h"
+#include "WwvbClockDefinitions.h"
+
+#if defined(__IMXRT1062__)
+extern "C" uint32_t set_arm_clock(uint32_t frequency); // Teensy 4 core, clockspeed.c
+#endif
+
+namespace {
+    const unsigned long BURST_HOLD_MSEC = 250;
+    // ORDER MUST MATCH ClockGovernor::Level_t
+    const uint32_t LEVEL_HZ[ClockGovernor::NUM_LEVELS] = { 24000000, 150000000, F_CPU };
+    const char * const LEVEL_NAMES[ClockGovernor::NUM_LEVELS] = { "Listen", "Idle", "Burst" };
+}
+
+ClockGovernor::ClockGovernor()
+    : m_enabled(false)
+    , m_level(LEVEL_BURST)
+    , m_burstMsec(0)
+    , m_levelBeganMsec(0)
+    , m_msecAtLevel()
+    , m_transitions(0)
+{}
+
+uint32_t ClockGovernor::levelHz(Level_t v)
+{
+    return LEVEL_HZ[v];
+}
+
+void ClockGovernor::setup(bool enable)
+{
+    m_levelBeganMsec = millis();
+    m_burstMsec = m_levelBeganMsec;
+    this->enable(enable);
+}
+
+void ClockGovernor::enable(bool v)
+{
+    m_enabled = v;
+    if (!m_enabled)
+        setLevel(LEVEL_BURST, millis());
+}
+
+void ClockGovernor::setLevel(Level_t v, unsigned long now)
+{
+    m_msecAtLevel[m_level] += now - m_levelBeganMsec;
+    m_levelBeganMsec = now;
+    if (v == m_level)
+        return;
+#if defined(__IMXRT1062__)
+    set_arm_clock(LEVEL_HZ[v]);
+#endif
+    m_level = v;
+    m_transitions += 1;
+    EventLog::log(EventLog::CPU_LEVEL, v);
+}
+
+void ClockGovernor::burst()
+{
+    auto now = millis();
+    m_burstMsec = now;
+    if (m_enabled && m_level != LEVEL_BURST)
+        setLevel(LEVEL_BURST, now);
+}
+
+void ClockGovernor::loop(bool es100Listening)
+{
+    if (!m_enabled)
+        return;
+    auto now = millis();
+    if (m_level == LEVEL_BURST && now - m_burstMsec < BURST_HOLD_MSEC)
+        return;
+    setLevel(es100Listening ? LEVEL_LISTEN : LEVEL_IDLE, now);
+}
+
+void ClockGovernor::printStatistics()
+{
+#if USE_SERIAL
+    setLevel(m_level, millis()); // bring the current level's time up to date
+    Serial.print(F("CpuGovernor "));
+    Serial.println(m_enabled ? F("enabled") : F("disabled"));
+    uint64_t total = 0;
+    for (int i = 0; i < NUM_LEVELS; i++)
+        total += m_msecAtLevel[i];
+    for (int i = 0; i < NUM_LEVELS; i++)
+    {
+        Serial.print(F("   "));
+        Serial.print(LEVEL_NAMES[i]);
+        Serial.print(F(" MHz="));
+        Serial.print(LEVEL_HZ[i] / 1000000);
+        Serial.print(F(" seconds="));
+        Serial.print(static_cast<uint32_t>(m_msecAtLevel[i] / 1000));
+        Serial.print(F(" percent="));
+        Serial.println(total ? static_cast<unsigned>((100ull * m_msecAtLevel[i]) / total) : 0u);
+    }
+    Serial.print(F("   transitions="));
+    Serial.println(m_transitions);
+#endif
+}
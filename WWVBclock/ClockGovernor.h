@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+
+/* The ClockGovernor runs the Teensy 4 ARM core slower than its 600MHz default
+** whenever the sketch has nothing to do but keep time. It runs slowest of all
+** while the ES100 is listening, because the core's switching noise is right
+** next to the 60KHz antenna.
+** Bursts of work, like a received radio packet or a serial command, call burst()
+** to get full speed back immediately. The governor drops back down after
+** BURST_HOLD_MSEC with no further burst() calls.
+**
+** Nothing else in the sketch depends on the ARM clock rate:
+**      millis() is counted from the 100KHz systick reference, not the core clock
+**      micros() and delayMicroseconds() scale by F_CPU_ACTUAL, which set_arm_clock updates
+**      LPSPI (SPI_CLOCK for the LED and RFM69) and LPI2C (ES100 on Wire1) have their own clock roots
+** ...so the LED SPI rate, the LiquidCrystal delays and the i2c timing are the same at every level.
+*/
+class ClockGovernor {
+    public:
+        enum Level_t {LEVEL_LISTEN, LEVEL_IDLE, LEVEL_BURST, NUM_LEVELS};
+        ClockGovernor();
+        void setup(bool enable);
+        void enable(bool);
+        void loop(bool es100Listening);
+        void burst(); // call when work arrives that needs the fast clock
+        void printStatistics();
+        static uint32_t levelHz(Level_t);
+
+    protected:
+        void setLevel(Level_t, unsigned long now);
+        bool m_enabled;
+        Level_t m_level;
+        unsigned long m_burstMsec;
+        unsigned long m_levelBeganMsec;
+        uint64_t m_msecAtLevel[NUM_LEVELS]; // 32 bits of msec would wrap in 49.7 days
+        uint32_t m_transitions;
+};
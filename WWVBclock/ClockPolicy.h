@@ -0,0 +1,51 @@
+#pragma once
+#include "HCMS290X.h"
+#include "WwvbClockDefinitions.h"
+
+enum Led_Font_enum {HCMS_OEM_FONT_IDX,     HCMS_SMALLDIG_FONT_IDX,        HCMS_7SEG_FONT_IDX,
+                    FLIPPED_FONT_INCREMENT,
+                    HCMS_FLIPPED_OEM_FONT_IDX = FLIPPED_FONT_INCREMENT, HCMS_FLIPPED_SMALLDIG_FONT_IDX, HCMS_FLIPPED_7SEG_FONT_IDX,
+                NUM_LED_FONTS};
+
+/* ClockPolicy selects at compile time what goes into the image:
+**      Led             the HCMS-290x hardware variant
+**      FlippedFonts    the up/down flipped rasters, for projecting the LED through a lens.
+**                      Without them, the flipped font indices show the upright fonts,
+**                      and nothing references the flipped rasters.
+**      Diagnostics     the latency, task, SPI, memory and boot reports.
+**                      Without them, their commands still parse but print nothing, and
+**                      the report functions are never referenced.
+** The Teensy 4 link uses --gc-sections, so whatever nothing references is left out of the image.
+** The size table is in WwvbClockDefinitions.h.
+*/
+template <LED_Hardware_e Led, bool FlippedFonts, bool Diagnostics>
+struct ClockPolicy {
+    typedef Hcms290X<Led> Hcms290x_t;
+    static const bool FLIPPED_FONTS = FlippedFonts;
+    static const bool DIAGNOSTICS = Diagnostics;
+    // the fonts the image holds, which are the first FONTS_IN_IMAGE entries of fonts
+    static const uint8_t FONTS_IN_IMAGE = FlippedFonts ? NUM_LED_FONTS : FLIPPED_FONT_INCREMENT;
+    static const Raster5x7Font *fonts[NUM_LED_FONTS];
+};
+
+template <LED_Hardware_e Led, bool FlippedFonts, bool Diagnostics>
+const Raster5x7Font *ClockPolicy<Led, FlippedFonts, Diagnostics>::fonts[NUM_LED_FONTS] =
+{   // ORDER in array MUST MATCH enum Led_Font_enum
+    &gOem5x7Font,
+    &gSmallDigits5x7Font,
+    &gDigits7Seg5x7Font,
+    FlippedFonts ? &gOem5x7FontFlipped : &gOem5x7Font,
+    FlippedFonts ? &gSmallDigits5x7FontFlipped : &gSmallDigits5x7Font,
+    FlippedFonts ? &gDigits7Seg5x7FontFlipped : &gDigits7Seg5x7Font,
+};
+
+#if (DUAL_ROW_LED_DISPLAY == 0)
+#define CLOCK_LED_HARDWARE LED_Hardware_e::SINGLE_ROW_OF_FOUR
+#elif (FLIPPED_LED_UPDOWN == 0)
+#define CLOCK_LED_HARDWARE LED_Hardware_e::DOUBLE_ROWS_OF_FOURS
+#else
+#define CLOCK_LED_HARDWARE LED_Hardware_e::DOUBLE_ROWS_OF_FOURS_FLIPPED_UPDOWN
+#endif
+
+typedef ClockPolicy<CLOCK_LED_HARDWARE, (FLIPPED_LED_FONTS != 0), (USE_SERIAL != 0) && (CLOCK_DIAGNOSTICS != 0)> ClockPolicy_t;
+typedef ClockPolicy_t::Hcms290x_t Hcms290xType_t;
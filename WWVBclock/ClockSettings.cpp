@@ -50,12 +50,7 @@ namespace {
     namespace tz {
         void tzApply(uint8_t, uint8_t tz)
         {
-            char buf[80];
-            char *p = buf;
-            const char *q = CLOCKCOMMANDS[static_cast<int>(ClockCommands_t::TimeZoneOffset)];
-            while (*p++ = *q++);
-            itoa(-60 * (4 + tz),--p, 10);
-            routeCommand(buf, 1+strlen(buf));
+            applyClockCommand(ClockCommands_t::TimeZoneOffset, -60 * (4 + tz));
         }
         const char * const options[] = {"Atlantic", "Eastern", "Central", "Mountain", "Pacific", "Alaska", "Hawaii"};
         SetupParameter p("TimeZone", -1, DIM(options), options, &tzApply);
@@ -77,46 +72,13 @@ namespace {
         {
             if (brite >= NUM_BRITES)
             {
-                static const char pwmOff[] = "LedPwm=0";
-                routeCommand(pwmOff, strlen(pwmOff)+1);
+                applyClockCommand(ClockCommands_t::LedPWM, 0);
                 return;
             }
-            static const char pwmOn[] = "LedPwm=";
-            char buf[80];
-            char *r = buf;
-            const char *q = pwmOn;
-            while (*r++ = *q++);
-            r -= 1;
-            char current = '0';
-            switch (brite)
-            {   // PWM
-                case 0:
-                    strcpy(r, "1");
-                    break;
-                case 1:
-                    strcpy(r, "5");
-                    current = '0';
-                    break;
-                case 2:
-                    strcpy(r, "8");
-                    current = '1';
-                    break;
-                case 3:
-                    strcpy(r, "12");
-                    current = '2';
-                    break;
-                case 4:
-                    strcpy(r, "15");
-                    current = '3';
-                    break;
-            }
-            routeCommand(buf, strlen(buf)+1);
-            r = buf;
-            q = CLOCKCOMMANDS[static_cast<int>(ClockCommands_t::LedCurrent)];
-            while (*r++ = *q++);
-            *--r = current;
-            *++r = 0;
-            routeCommand(buf, strlen(buf) + 1);
+            static const uint8_t pwm[NUM_BRITES] = {1, 5, 8, 12, 15, 0};
+            static const uint8_t current[NUM_BRITES] = {0, 0, 1, 2, 3, 0};
+            applyClockCommand(ClockCommands_t::LedPWM, pwm[brite]);
+            applyClockCommand(ClockCommands_t::LedCurrent, current[brite]);
         }
         const char * const options[NUM_BRITES] = {"Min","Low", "Medim", "High", "Max", "Off", };
         SetupParameter p("Bright", -1, NUM_BRITES, options, &apply);
@@ -125,19 +87,8 @@ namespace {
     namespace r180 {
         void apply(uint8_t, uint8_t rf)
         {
-            char buf[80];
-            char *p = buf;
-            const char *q = CLOCKCOMMANDS[static_cast<int>(ClockCommands_t::RotateLed180)];
-            while (*p++ = *q++);
-            *--p =  (rf & 1) == 0 ? '0' : '1';
-            *++p = 0;
-            routeCommand(buf, 1+strlen(buf));
-            p = buf;
-            q = CLOCKCOMMANDS[static_cast<int>(ClockCommands_t::UseFlippedFonts)];
-            while (*p++ = *q++);
-            *--p =  (rf & 2) == 0 ? '0' : '1';
-            *++p = 0;
-            routeCommand(buf, 1+strlen(buf));
+            applyClockCommand(ClockCommands_t::RotateLed180, (rf & 1) == 0 ? 0 : 1);
+            applyClockCommand(ClockCommands_t::UseFlippedFonts, (rf & 2) == 0 ? 0 : 1);
         }
         const char * const options[] = {"No", "Yes", "No&Mirror", "Yes&Mirro"};
         SetupParameter p("Rotate", -1, DIM(options), options, &apply);
@@ -234,7 +185,7 @@ namespace {
 
 time_t ClockSettings::g_es100UpdatedAt(0);
 
-ClockSettings::ClockSettings(LiquidCrystal &lcd) 
+ClockSettings::ClockSettings(LiquidCrystal &lcd, Buttons &buttons)
     :m_state(IDLE)
     ,m_curParam(0)
     ,m_curOption(0)
@@ -243,6 +194,7 @@ ClockSettings::ClockSettings(LiquidCrystal &lcd)
     ,m_prevSw2(false)
     ,m_haveSetTime(false)
     ,lcd(lcd)
+    ,m_buttons(buttons)
 {
 }
 
@@ -259,9 +211,20 @@ void ClockSettings::es100UpdatedAt(time_t t)
     g_es100UpdatedAt = t;
 }
 
-bool ClockSettings::loop(bool sw1, bool sw2)
+bool ClockSettings::loop()
+{   // each button edge at the time it happened, then holds and timeouts as of now
+    Buttons::Event e;
+    while (m_buttons.pop(e))
+    {
+        bool sw1 = e.button == Buttons::SW1 ? e.pressed : m_prevSw1;
+        bool sw2 = e.button == Buttons::SW2 ? e.pressed : m_prevSw2;
+        step(e.msec, sw1, sw2);
+    }
+    return step(millis(), m_prevSw1, m_prevSw2);
+}
+
+bool ClockSettings::step(unsigned long now, bool sw1, bool sw2)
 {
-    auto now = millis();
     static_assert(sizeof(now) == sizeof(m_lastButtonMsec), "Time type wrong");
     int delay = static_cast<int>(now - m_lastButtonMsec);
     bool ret = false;
@@ -435,15 +398,8 @@ void ClockSettings::displayCurrentSw1()
     DEBUG_OUTPUT1(" command: ");
     DEBUG_OUTPUT1(optionCommand);
     DEBUG_OUTPUT1('\n');
-    if (optionCommand > 0)
-    {  
-        char buf[80];
-        const char *q = CLOCKCOMMANDS[optionCommand];
-        char *r = buf;
-        while (*r++ = *q++);
-        itoa(o, --r, 10);
-        routeCommand(buf, 1+strlen(buf));
-    }
+    if (optionCommand >= 0)
+        applyClockCommand(static_cast<ClockCommands_t>(optionCommand), o);
  }
 
  void ClockSettings::processSw2Buttons(unsigned long tm, bool sw1, bool sw2)
@@ -473,11 +429,11 @@ void ClockSettings::displayCurrentSw1()
     else if (sw1 && delay >= LONG_PRESS_MSEC)
     {
         setTime(now() + 3600);
-        m_lastButtonMsec = tm;
+        m_lastButtonMsec += LONG_PRESS_MSEC; // repeat on time, however late this step runs
     }
     else if (sw2 && delay >= LONG_PRESS_MSEC)
     {
         setTime(now() - 3600);
-        m_lastButtonMsec = tm;
+        m_lastButtonMsec += LONG_PRESS_MSEC;
     }
  }
\ No newline at end of file
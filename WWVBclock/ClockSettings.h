@@ -1,20 +1,22 @@
 #pragma once
 #include <LiquidCrystal.h>
 #include <TimeLib.h>
+#include "Buttons.h"
 
 // class to manipulate clock settings based on user pressing sw1 and sw2
 
 class ClockSettings {
     public:
-        ClockSettings(LiquidCrystal &lcd);
+        ClockSettings(LiquidCrystal &lcd, Buttons &buttons);
         void setup();
-        bool loop(bool sw1, bool sw2);
+        bool loop(); // true while it has the LCD
         void es100UpdatedAt(time_t);
         static const char *optionName(uint8_t param, uint8_t opt);
         static time_t g_es100UpdatedAt;
         static void applySw1(uint8_t param, uint8_t opt);
 
     protected:
+        bool step(unsigned long now, bool sw1, bool sw2);
         void displayCurrentSw1();
         void processSw1Buttons(unsigned long mil, bool sw1, bool sw2);
         void processSw2Buttons(unsigned long mil, bool sw1, bool sw2);
@@ -26,4 +28,5 @@ class ClockSettings {
         bool m_prevSw2;
         bool m_haveSetTime;
            LiquidCrystal &lcd;
+        Buttons &m_buttons;
 };
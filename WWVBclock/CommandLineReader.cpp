@@ -0,0 +1,59 @@
+#include "CommandLineReader.h"
+#include "WwvbClockDefinitions.h"
+
+CommandLineReader::CommandLineReader(Stream &stream)
+    : m_stream(stream)
+    , m_len(0)
+    , m_complete(false)
+    , m_overflow(false)
+    , m_prevCr(false)
+    , m_overflows(0)
+{
+    m_line[0] = 0;
+}
+
+char *CommandLineReader::loop()
+{
+    if (m_complete)
+    {   // caller is done with the previous line
+        m_complete = false;
+        m_len = 0;
+    }
+    while (m_stream.available())
+    {
+        auto c = m_stream.read();
+        if (c < 0)
+            break;
+        auto ch = static_cast<char>(c);
+        bool lf = ch == '\n';
+        if (lf && m_prevCr)
+        {   // second half of CR LF
+            m_prevCr = false;
+            continue;
+        }
+        m_prevCr = ch == '\r';
+        if (lf || m_prevCr)
+        {
+            m_line[m_len] = 0;
+            if (m_overflow)
+            {
+                m_overflow = false;
+                m_overflows += 1;
+                m_len = 0;
+#if USE_SERIAL
+                Serial.print(F("Line longer than "));
+                Serial.print(LINE_BUFLEN);
+                Serial.println(F(" ignored"));
+#endif
+                continue;
+            }
+            m_complete = true;
+            return m_line;
+        }
+        if (m_len < LINE_BUFLEN)
+            m_line[m_len++] = ch;
+        else
+            m_overflow = true;
+    }
+    return nullptr;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <Arduino.h>
+
+/* CommandLineReader collects characters from a Stream into whole lines.
+** The USB serial driver already buffers what arrives between calls to loop(), so
+** loop() drains it each time rather than taking a character per pass.
+**
+** A line longer than LINE_BUFLEN is thrown away, and counted, rather than run
+** as a truncated command.
+*/
+class CommandLineReader {
+    public:
+        static const uint16_t LINE_BUFLEN = 256;
+
+        CommandLineReader(Stream &stream);
+        // returns a complete, zero terminated line, or nullptr if none yet.
+        // The line is good until the next call. Empty lines are returned, so a prompt can be printed.
+        char *loop();
+        uint16_t overflows() const { return m_overflows; }
+
+    protected:
+        Stream &m_stream;
+        char m_line[LINE_BUFLEN + 1];
+        uint16_t m_len;
+        bool m_complete;
+        bool m_overflow;
+        bool m_prevCr;
+        uint16_t m_overflows;
+};
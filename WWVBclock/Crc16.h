@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-16/CCITT-FALSE. Pass the previous result as crc to continue over more bytes
+inline uint16_t crc16(const void *data, size_t len, uint16_t crc = 0xFFFF)
+{
+    auto p = static_cast<const uint8_t *>(data);
+    while (len--)
+    {
+        crc ^= static_cast<uint16_t>(*p++) << 8;
+        for (uint8_t i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
@@ -1,6 +1,7 @@
 #include <Wire.h>
 #include "WwvbClockDefinitions.h"
 #include "Es100Wire.h"
+#include "EventLog.h"
 
 static const uint8_t ES100_SLAVE_ADDR (0x32);
 
@@ -35,11 +36,36 @@ static const uint8_t IRQSTATUS_RX_COMPLETE = 1;
 
 static const uint8_t DST_HOUR_SPECIAL3 = 1 << 7;
 
+static const uint32_t I2C_STANDARD_HZ = 100000;
+static const uint32_t I2C_FAST_HZ = 400000;
+static const uint8_t MAX_FAILURES = 8;
+static const unsigned long RECOVERY_RETRY_MSEC = 1000;
+static const unsigned long LISTEN_RETRY_MSEC = 100;
+static const uint32_t TRANSACTION_TIMEOUT_USEC = 5000; // a register read is under 1 msec at 100KHz
+static const unsigned RECOVERY_HALF_BIT_USEC = 5; // 100KHz
+// Wire results. Teensy 4 returns 4 when it gives up waiting on the bus
+static const uint8_t WIRE_ADDRESS_NACK = 2;
+static const uint8_t WIRE_DATA_NACK = 3;
+static const uint8_t WIRE_TIMEOUT = 4;
+static const uint8_t WIRE_SHORT_READ = 0xFF; // ours, for requestFrom
 
-Es100Wire::Es100Wire(int irqPin, int enablePin, TwoWire &wire) 
+
+Es100Wire::Es100Wire(int irqPin, int enablePin, TwoWire &wire, uint8_t sclPin, uint8_t sdaPin)
     :irqPin(irqPin)
     ,enablePin(enablePin)
     ,Wire(wire)
+    ,sclPin(sclPin)
+    ,sdaPin(sdaPin)
+    ,m_errors()
+    ,m_transactions(0)
+    ,m_recoveries(0)
+    ,m_stuck(0)
+    ,m_recoveryUsec(0)
+    ,m_failures(0)
+    ,m_fastMode(false)
+    ,m_wireBegun(false)
+    ,m_retryMsec(0)
+    ,m_retryPending(false)
     ,m_state(ReceptionState::SHUTDOWN)
     ,m_time(0)
     ,m_status0(0)
@@ -57,7 +83,7 @@ void Es100Wire::setup(bool enable)
     if (!enable)
         return;
 
-    Wire.begin();
+    beginWire();
     pinMode(irqPin, INPUT);
     digitalWrite(enablePin, HIGH);
     attachInterrupt(irqPin, &Es100Wire::isr, FALLING);
@@ -70,11 +96,57 @@ void Es100Wire::setup(bool enable)
     digitalWrite(enablePin, LOW);
 }
 
+void Es100Wire::beginWire()
+{
+    Wire.begin();
+    Wire.setClock(m_fastMode ? I2C_FAST_HZ : I2C_STANDARD_HZ);
+    m_wireBegun = true;
+}
+
+void Es100Wire::setFastMode(bool fast)
+{
+    m_fastMode = fast;
+    if (m_wireBegun)
+        Wire.setClock(m_fastMode ? I2C_FAST_HZ : I2C_STANDARD_HZ);
+}
+
+Es100Wire::DstStatus Es100Wire::dstStatus() const
+{
+    DstStatus v;
+    v.status0 = m_status0;
+    v.nextMonth = m_nextDstMonthStatus;
+    v.nextDay = m_nextDstDayStatus;
+    v.nextHour = m_nextDstHourStatus;
+    v.year = m_yearOfDst;
+    return v;
+}
+
+void Es100Wire::restoreDstStatus(const DstStatus &v)
+{
+    m_status0 = v.status0;
+    m_nextDstMonthStatus = v.nextMonth;
+    m_nextDstDayStatus = v.nextDay;
+    m_nextDstHourStatus = v.nextHour;
+    m_yearOfDst = v.year;
+}
+
 uint8_t Es100Wire::fromBCD(int16_t v)
 {
     return static_cast<uint8_t>(((v & 0xF0u) >> 4) * 10u + (v & 0xFu));
 }
 
+bool Es100Wire::readFailed()
+{   /* The IRQ that started this is already cleared, so an RX_COMPLETE whose read
+    ** failed would never come again. Go back to IDLE, and loop() issues listen() again */
+    m_state = ReceptionState::IDLE;
+    if (!m_retryPending)
+    {
+        m_retryPending = true;
+        m_retryMsec = millis() + LISTEN_RETRY_MSEC;
+    }
+    return false;
+}
+
 bool Es100Wire::loop(bool isSynced)
 {
     if (isSynced)
@@ -83,6 +155,12 @@ bool Es100Wire::loop(bool isSynced)
             shutdown();
         return false;
     }
+    if (m_retryPending)
+    {   // after a failed listen() or a bus recovery
+        if (static_cast<long>(millis() - m_retryMsec) < 0)
+            return false;
+        m_retryPending = false;
+    }
     if (m_state != ReceptionState::ACTIVE)
     {
         listen();
@@ -95,44 +173,42 @@ bool Es100Wire::loop(bool isSynced)
     if (triggered)
     {
         auto irqStatus = readRegister(ES100_IRQ_STATUS_REG);
-        DEBUG_OUTPUT1(F("Es100 interrupt: 0x"));
-        DEBUG_OUTPUT2(static_cast<unsigned>(irqStatus), HEX);
-        DEBUG_OUTPUT1('\n');
+        EventLog::log(EventLog::ES100_IRQ, irqStatus);
         if (irqStatus < 0)
-            return false;
+            return readFailed();
         if (irqStatus & IRQSTATUS_RX_COMPLETE)
         {
             // got something!
             TimeElements toRead = {};
             auto yr = readRegister(ES100_YEAR_REG);
             if (yr < 0)
-                return false;
+                return readFailed();
             toRead.Year = (2000 - 1970) + fromBCD(yr);
             m_yearOfDst = toRead.Year;
 
             auto mo = readRegister(ES100_MONTH_REG);
             if (mo < 0)
-                return false;
+                return readFailed();
             toRead.Month = fromBCD(mo);
 
             auto dy = readRegister(ES100_DAY_REG);
             if (dy < 0)
-                return false;
+                return readFailed();
             toRead.Day = fromBCD(dy);
 
             auto hr = readRegister(ES100_HOUR_REG);
             if (hr < 0)
-                return false;
+                return readFailed();
             toRead.Hour = fromBCD(hr);
 
             auto mn = readRegister(ES100_MINUTE_REG);
             if (mn < 0)
-                return false;
+                return readFailed();
             toRead.Minute = fromBCD(mn);
 
             auto sc = readRegister(ES100_SECOND_REG);
             if (sc < 0)
-                return false;
+                return readFailed();
             toRead.Second = fromBCD(sc);
             DEBUG_OUTPUT1(F("WWVB time.\n"));
             debugPrint(toRead);
@@ -168,9 +244,7 @@ time_t Es100Wire::getUTCandClear()
 
 void Es100Wire::shutdown()
 {
-#if USE_SERIAL
-    Serial.print(F("Es100Wire::shutdown\n"));
-#endif
+    EventLog::log(EventLog::ES100_SHUTDOWN);
     digitalWrite(enablePin, LOW);
     m_state = ReceptionState::SHUTDOWN;
 }
@@ -180,32 +254,32 @@ void Es100Wire::listen()
     digitalWrite(enablePin, HIGH);
     if (writeRegister(ES100_CONTROL0_REG, CONTROL0_START | CONTROL0_ANT2_OFF))
     {
-#if USE_SERIAL
-        Serial.print(F("Es100Wire::listen\n"));
-#endif
+        EventLog::log(EventLog::ES100_LISTEN);
         m_state = ReceptionState::ACTIVE;
     }
+    else if (!m_retryPending)
+    {
+        m_retryPending = true;
+        m_retryMsec = millis() + LISTEN_RETRY_MSEC;
+    }
 }
 
 bool Es100Wire::writeRegister(uint8_t reg, uint8_t val)
 {
     uint8_t buf[2] = {reg,val};
+    auto began = micros();
     Wire.beginTransmission(ES100_SLAVE_ADDR);
     Wire.write(buf, sizeof(buf));
     auto r = Wire.endTransmission();
-    if (r != 0)
+    if (!transactionDone(r, began))
     {
         if (r != m_errorReported)
-        {
-            DEBUG_OUTPUT1(F("Es100Wire::writeRegister failed: "));
-            DEBUG_OUTPUT1(r);
-            DEBUG_OUTPUT1('\n');
-        }
+            EventLog::log(EventLog::ES100_WRITE_FAILED, reg, r);
         m_errorReported = r;
     }
     else if (m_errorReported != 0)
     {
-        DEBUG_OUTPUT1(F("Es100Wire::writeRegister success.\n"));
+        EventLog::log(EventLog::ES100_WRITE_OK);
         m_errorReported = 0;
     }
     return r == 0;
@@ -213,31 +287,123 @@ bool Es100Wire::writeRegister(uint8_t reg, uint8_t val)
 
 int16_t Es100Wire::readRegister(uint8_t reg)
 {   
+    auto began = micros();
     Wire.beginTransmission(ES100_SLAVE_ADDR);
     Wire.write(reg);
-    if (0 != Wire.endTransmission())
-        return -1;
-    if (1 != Wire.requestFrom(ES100_SLAVE_ADDR, static_cast<uint8_t>(1), true))
+    auto r = Wire.endTransmission();
+    if (r == 0 && 1 != Wire.requestFrom(ES100_SLAVE_ADDR, static_cast<uint8_t>(1), true))
+        r = WIRE_SHORT_READ;
+    if (!transactionDone(r, began))
     {
-        DEBUG_OUTPUT1(F("Es100Wire::readRegister failed\n"));
+        EventLog::log(EventLog::ES100_READ_FAILED, reg);
         return -1;
     }
     return static_cast<uint8_t>(Wire.read());
 }
 
+bool Es100Wire::transactionDone(uint8_t result, unsigned long beganUsec)
+{
+    m_transactions += 1;
+    bool slow = micros() - beganUsec > TRANSACTION_TIMEOUT_USEC;
+    if (result == 0)
+    {
+        if (slow)
+            m_errors[ERROR_TIMEOUT] += 1; // the data is good, but something held the bus
+        m_failures = 0;
+        return true;
+    }
+    Error_t e = ERROR_OTHER;
+    switch (result)
+    {
+        case WIRE_ADDRESS_NACK: e = ERROR_ADDRESS_NACK; break;
+        case WIRE_DATA_NACK: e = ERROR_DATA_NACK; break;
+        case WIRE_TIMEOUT: e = ERROR_TIMEOUT; break;
+        case WIRE_SHORT_READ: e = ERROR_SHORT_READ; break;
+        default: break;
+    }
+    if (slow)
+        e = ERROR_TIMEOUT;
+    m_errors[e] += 1;
+    m_failures += 1;
+    if (e == ERROR_TIMEOUT || m_failures >= MAX_FAILURES)
+        recoverBus();
+    return false;
+}
+
+void Es100Wire::recoverBus()
+{   // the pins are GPIO until beginWire(). Released lines float up; driven ones are open drain
+    auto began = micros();
+    m_recoveries += 1;
+    pinMode(sdaPin, INPUT_PULLUP);
+    pinMode(sclPin, INPUT_PULLUP);
+    delayMicroseconds(RECOVERY_HALF_BIT_USEC);
+    for (uint8_t i = 0; i < 9 && digitalRead(sdaPin) == LOW; i++)
+    {   // clock out whatever byte the ES100 thinks it is in the middle of
+        pinMode(sclPin, OUTPUT_OPENDRAIN);
+        digitalWrite(sclPin, LOW);
+        delayMicroseconds(RECOVERY_HALF_BIT_USEC);
+        pinMode(sclPin, INPUT_PULLUP);
+        delayMicroseconds(RECOVERY_HALF_BIT_USEC);
+    }
+    // STOP: SDA rises while SCL is high
+    pinMode(sdaPin, OUTPUT_OPENDRAIN);
+    digitalWrite(sdaPin, LOW);
+    delayMicroseconds(RECOVERY_HALF_BIT_USEC);
+    pinMode(sdaPin, INPUT_PULLUP);
+    delayMicroseconds(RECOVERY_HALF_BIT_USEC);
+    bool idle = digitalRead(sdaPin) == HIGH && digitalRead(sclPin) == HIGH;
+    if (!idle)
+        m_stuck += 1;
+    beginWire();
+    uint32_t usec = micros() - began;
+    m_recoveryUsec += usec;
+    m_failures = 0;
+    if (m_state == ReceptionState::ACTIVE)
+        m_state = ReceptionState::IDLE; // a brown out may have reset the ES100. listen() again after the retry
+    m_retryPending = true;
+    m_retryMsec = millis() + RECOVERY_RETRY_MSEC;
+    EventLog::log(EventLog::ES100_BUS_RECOVERY, idle, static_cast<int32_t>(usec));
+}
+
+void Es100Wire::printStatistics()
+{
+#if USE_SERIAL
+    // ORDER MUST MATCH Error_t
+    static const char * const ERROR_NAMES[NUM_ERRORS] = { "addressNack", "dataNack", "timeout", "shortRead", "other" };
+    Serial.print(F("ES100 i2c KHz="));
+    Serial.print((m_fastMode ? I2C_FAST_HZ : I2C_STANDARD_HZ) / 1000);
+    Serial.print(F(" transactions="));
+    Serial.println(m_transactions);
+    Serial.print(F(" errors:"));
+    for (uint8_t i = 0; i < NUM_ERRORS; i++)
+    {
+        Serial.print(' ');
+        Serial.print(ERROR_NAMES[i]);
+        Serial.print('=');
+        Serial.print(m_errors[i]);
+    }
+    Serial.println();
+    Serial.print(F(" recoveries="));
+    Serial.print(m_recoveries);
+    Serial.print(F(" stuck="));
+    Serial.print(m_stuck);
+    Serial.print(F(" recoveryUsec="));
+    Serial.println(m_recoveryUsec);
+#endif
+}
+
 int8_t Es100Wire::isDstNow()
 {
     if (m_status0 < 0)
         return -1; // use valid m_nextDstDayStatus as proxy for whether m_status0 is OK;
     uint8_t stat = (m_status0 & (STATUS_0_DST0 | STATUS_0_DST1 | STATUS_0_RXOK)) ;
-    DEBUG_OUTPUT1(F("Dst now is 0x"));
-    DEBUG_OUTPUT2(static_cast<unsigned>(stat), HEX);
-    DEBUG_OUTPUT1('\n');
+    int8_t ret = -1; // don't really know
     if (stat == STATUS_0_RXOK)
-        return 0;
-    if (stat == (STATUS_0_DST0 | STATUS_0_DST1 | STATUS_0_RXOK))
-        return 1;
-    return -1; // don't really know 
+        ret = 0;
+    else if (stat == (STATUS_0_DST0 | STATUS_0_DST1 | STATUS_0_RXOK))
+        ret = 1;
+    EventLog::log(EventLog::ES100_DST, stat, ret);
+    return ret;
 }
 
 bool Es100Wire::ScheduledDst(bool &begins, time_t &when, uint8_t &localHour) // returns UTC midnight of date of change
@@ -257,7 +423,6 @@ bool Es100Wire::ScheduledDst(bool &begins, time_t &when, uint8_t &localHour) //
              ((m_nextDstHourStatus >= 0) && 0 == ((m_nextDstHourStatus & DST_HOUR_SPECIAL3))) ?
                 m_nextDstHourStatus & 0xF
                 : 2;
-            DEBUG_OUTPUT1(F("DST from status0\n"));
         }
         else if ((m_nextDstHourStatus >= 0) && (m_nextDstDayStatus >= 0) && (m_nextDstMonthStatus >= 0) && 
             0 == (m_nextDstHourStatus & DST_HOUR_SPECIAL3))
@@ -266,7 +431,6 @@ bool Es100Wire::ScheduledDst(bool &begins, time_t &when, uint8_t &localHour) //
             t.Month = fromBCD(m_nextDstMonthStatus);
             t.Day = fromBCD(m_nextDstDayStatus);
             localHour = m_nextDstHourStatus & 0xF;
-            DEBUG_OUTPUT1(F("DST from DST HOUR\n"));
         }
         else 
             return false;
@@ -274,15 +438,8 @@ bool Es100Wire::ScheduledDst(bool &begins, time_t &when, uint8_t &localHour) //
     else 
         return false;
 
-    DEBUG_OUTPUT1(F("Scheduled DST."));
-    debugPrint(t);
-    DEBUG_OUTPUT1(F(" hour:"));
-    DEBUG_OUTPUT1(static_cast<uint16_t>(localHour));
-    if (begins)
-        DEBUG_OUTPUT1(F(" beginning\n"));
-    else
-        DEBUG_OUTPUT1(F(" ending\n"));
     when = makeTime(t);
+    EventLog::log(begins ? EventLog::ES100_DST_BEGINS : EventLog::ES100_DST_ENDS, static_cast<int32_t>(when), localHour);
     return true;
 }
 
@@ -3,15 +3,37 @@
 class Es100Wire
 {
 /* The ES100 is a WWVB receiver (60KHz) on a single die. Use i2c to talk to it.
+** The i2c link runs at 100KHz, or 400KHz fast mode.
+**
+** A brown-out can leave the ES100 holding SDA low partway through a byte, and
+** then every transaction fails. After a Wire timeout, or after MAX_FAILURES
+** failures in a row, the pins are taken back as GPIO. SCL is clocked up to
+** 9 times until SDA is released, then a STOP is sent and Wire starts over.
+** Recovery, and listen() after a failure, wait RETRY_MSEC before trying again.
 */
  public:
-    Es100Wire(int irqPin, int enablePin, TwoWire &);
+    Es100Wire(int irqPin, int enablePin, TwoWire &, uint8_t sclPin, uint8_t sdaPin);
     void setup(bool enable);
+    void setFastMode(bool); // 400KHz i2c
+    void printStatistics();
     bool loop(bool isSynced); // returns true when it has a receipt. 
     time_t getUTCandClear();
     int8_t isDstNow(); // WWVB reports every minute whether DST is now in effect
     bool ScheduledDst(bool &onOff, time_t &when, uint8_t &localHour); // returns UTC midnight of date of next change
     static void printClock();
+    bool isListening() const { return m_state == ReceptionState::ACTIVE; }
+    static bool pending() { return isrTriggered; } // loop() has an IRQ to service
+
+    // what the last reception said about DST. Kept across a warm restart
+    struct DstStatus {
+        int16_t status0;
+        int16_t nextMonth;
+        int16_t nextDay;
+        int16_t nextHour;
+        uint8_t year;
+    };
+    DstStatus dstStatus() const;
+    void restoreDstStatus(const DstStatus &);
     
  protected:
    void shutdown();
@@ -21,11 +43,28 @@ class Es100Wire
    void debugRegisterPrint();
    static uint8_t fromBCD(int16_t);
    int16_t readRegister(uint8_t reg);
+   bool transactionDone(uint8_t result, unsigned long beganUsec); // false and counted if it failed
+   void recoverBus();
+   bool readFailed(); // in the middle of reading a reception. Returns false
+   void beginWire();
    static void isr();
    enum class ReceptionState { SHUTDOWN, ACTIVE, IDLE};
    const int irqPin;
    const int enablePin;
    TwoWire &Wire;
+   const uint8_t sclPin;
+   const uint8_t sdaPin;
+   enum Error_t {ERROR_ADDRESS_NACK, ERROR_DATA_NACK, ERROR_TIMEOUT, ERROR_SHORT_READ, ERROR_OTHER, NUM_ERRORS};
+   uint32_t m_errors[NUM_ERRORS];
+   uint32_t m_transactions;
+   uint32_t m_recoveries;
+   uint32_t m_stuck; // recoveries that didn't free the bus
+   uint32_t m_recoveryUsec;
+   uint8_t m_failures; // in a row
+   bool m_fastMode;
+   bool m_wireBegun;
+   unsigned long m_retryMsec; // no transaction before this, if m_retryPending
+   bool m_retryPending;
    ReceptionState m_state;
    time_t m_time;
    int16_t m_status0;
@@ -0,0 +1,208 @@
+#include <Arduino.h>
+#include <ctype.h>
+#include <stddef.h>
+#include "EventLog.h"
+#include "NoInit.h"
+#include "WwvbClockDefinitions.h"
+
+namespace EventLog {
+namespace {
+    struct Record {
+        uint32_t msec;
+        int32_t a;
+        int16_t b;
+        uint8_t event;
+        uint8_t spare;
+    };
+    static_assert(sizeof(Record) == 12, "EventLog::Record has padding");
+
+    struct Ring {
+        uint32_t written; // ever, so written % CAPACITY is the next slot
+        uint32_t check;   // ~written
+        Record records[CAPACITY];
+    };
+    const uint32_t RING_MAGIC = 0x4576AA00ul ^ sizeof(Record);
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "EventLog::CAPACITY must be a power of 2");
+
+    DMAMEM NoInit<Ring, RING_MAGIC> noInitRing;
+    Ring &ring = noInitRing.data;
+
+    struct Info {
+        Level_t level;
+        const char *name;
+        const char *argA; // nullptr if unused
+        const char *argB;
+    };
+    // ORDER MUST MATCH Event_t
+    const Info INFO[NUM_EVENTS] = {
+        { LEVEL_WARN,  "Boot", "reset", nullptr },
+        { LEVEL_INFO,  "Es100Listen", nullptr, nullptr },
+        { LEVEL_INFO,  "Es100Shutdown", nullptr, nullptr },
+        { LEVEL_DEBUG, "Es100Irq", "status", nullptr },
+        { LEVEL_ERROR, "Es100WriteFailed", "reg", "result" },
+        { LEVEL_INFO,  "Es100WriteOK", nullptr, nullptr },
+        { LEVEL_WARN,  "Es100ReadFailed", "reg", nullptr },
+        { LEVEL_INFO,  "WwvbSync", "utc", "rtcError" },
+        { LEVEL_INFO,  "WwvbSearch", nullptr, nullptr },
+        { LEVEL_INFO,  "RadioSilence", "on", nullptr },
+        { LEVEL_DEBUG, "RadioAck", "sender", "msec" },
+        { LEVEL_DEBUG, "RadioLoopDelay", "msec", nullptr },
+        { LEVEL_INFO,  "SensorTemperature", "sender", "Cx100" },
+        { LEVEL_INFO,  "SensorRain", "sender", "rg" },
+        { LEVEL_DEBUG, "CpuLevel", "level", nullptr },
+        { LEVEL_WARN,  "Es100BusRecovery", "idle", "usec" },
+        { LEVEL_DEBUG, "TransmitQueued", "dest", "seq" },
+        { LEVEL_DEBUG, "TransmitDone", "seq", "status" },
+        { LEVEL_DEBUG, "RadioAwake", "awake", nullptr },
+        { LEVEL_DEBUG, "RaingaugeDelta", "sender", "diffF" },
+        { LEVEL_DEBUG, "Es100Dst", "status", "now" },
+        { LEVEL_INFO,  "Es100DstBegins", "utc", "hour" },
+        { LEVEL_INFO,  "Es100DstEnds", "utc", "hour" },
+    };
+    // ORDER MUST MATCH Level_t
+    const char * const LEVEL_NAMES[NUM_LEVELS] = { "Error", "Warn", "Info", "Debug" };
+    const char LEVEL_LETTERS[NUM_LEVELS] = { 'E', 'W', 'I', 'D' };
+
+#if defined(DEBUG_TO_SERIAL)
+    const Level_t ECHO_LEVEL = LEVEL_DEBUG;
+#else
+    const Level_t ECHO_LEVEL = LEVEL_INFO;
+#endif
+    const uint8_t ECHO_PER_LOOP = 4;
+
+    Level_t threshold = LEVEL_DEBUG;
+    uint32_t echoed;
+
+    void print(const Record &r)
+    {
+#if USE_SERIAL
+        const auto &info = INFO[r.event < NUM_EVENTS ? r.event : static_cast<uint8_t>(BOOT)];
+        Serial.print(r.msec);
+        Serial.print(' ');
+        Serial.print(LEVEL_LETTERS[info.level]);
+        Serial.print(' ');
+        if (r.event < NUM_EVENTS)
+            Serial.print(info.name);
+        else
+        {
+            Serial.print(F("event"));
+            Serial.print(static_cast<int>(r.event));
+        }
+        if (info.argA)
+        {
+            Serial.print(' ');
+            Serial.print(info.argA);
+            Serial.print('=');
+            Serial.print(r.a);
+        }
+        if (info.argB)
+        {
+            Serial.print(' ');
+            Serial.print(info.argB);
+            Serial.print('=');
+            Serial.print(r.b);
+        }
+        Serial.println();
+#endif
+    }
+}
+
+void setup(uint32_t resetReason)
+{
+    if (!noInitRing.valid() || ring.check != ~ring.written)
+    {   // power up. Nothing in the ring is real
+        ring.written = 0;
+    }
+    noInitRing.claim();
+    echoed = ring.written;
+    log(BOOT, static_cast<int32_t>(resetReason));
+}
+
+void setLevel(Level_t v)
+{
+    threshold = v < NUM_LEVELS ? v : LEVEL_DEBUG;
+}
+
+Level_t level()
+{
+    return threshold;
+}
+
+void log(Event_t e, int32_t a, int32_t b)
+{
+    if (e >= NUM_EVENTS || INFO[e].level > threshold)
+        return;
+    auto &r = ring.records[ring.written & (CAPACITY - 1)];
+    r.msec = millis();
+    r.a = a;
+    r.b = b > INT16_MAX ? INT16_MAX : (b < INT16_MIN ? INT16_MIN : static_cast<int16_t>(b));
+    r.event = e;
+    r.spare = 0;
+    ring.written += 1;
+    ring.check = ~ring.written;
+    noInitRing.flush(r);
+    noInitRing.flush(ring, offsetof(Ring, records));
+}
+
+void loop()
+{
+    if (ring.written - echoed > CAPACITY)
+        echoed = ring.written - CAPACITY; // fell behind. The oldest are gone
+#if USE_SERIAL
+    bool connected = Serial;
+#else
+    bool connected = false;
+#endif
+    for (uint8_t i = 0; i < ECHO_PER_LOOP && echoed != ring.written; i++)
+    {
+        const auto &r = ring.records[echoed++ & (CAPACITY - 1)];
+        if (connected && r.event < NUM_EVENTS && INFO[r.event].level <= ECHO_LEVEL)
+            print(r);
+    }
+}
+
+void dump(uint16_t count)
+{
+#if USE_SERIAL
+    uint32_t held = ring.written < CAPACITY ? ring.written : CAPACITY;
+    if (count > held)
+        count = static_cast<uint16_t>(held);
+    Serial.print(F("EventLog level="));
+    Serial.print(LEVEL_NAMES[threshold]);
+    Serial.print(F(" written="));
+    Serial.print(ring.written);
+    Serial.print(F(" showing="));
+    Serial.println(count);
+    for (uint32_t i = ring.written - count; i != ring.written; i++)
+        print(ring.records[i & (CAPACITY - 1)]);
+#endif
+}
+
+const void *ringAddress()
+{
+    return &noInitRing;
+}
+
+uint32_t ringBytes()
+{
+    return sizeof(noInitRing);
+}
+
+const char *levelName(Level_t v)
+{
+    return v < NUM_LEVELS ? LEVEL_NAMES[v] : "?";
+}
+
+bool levelFromChar(char c, Level_t &v)
+{
+    c = static_cast<char>(toupper(c));
+    for (uint8_t i = 0; i < NUM_LEVELS; i++)
+        if (c == LEVEL_LETTERS[i] || c == '0' + i)
+        {
+            v = static_cast<Level_t>(i);
+            return true;
+        }
+    return false;
+}
+
+}
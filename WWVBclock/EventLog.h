@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+
+/* EventLog is a ring of the last CAPACITY events in RAM, recorded in binary
+** as an event ID and up to two arguments. Recording one costs about as much as a
+** function call, so it stays on in a production clock. Formatting happens later:
+** loop() echoes INFO and more severe events to Serial a few at a time, and
+** the DumpLog command prints what the ring holds.
+**
+** The ring is in DMAMEM, which the startup code doesn't clear, so the events leading
+** up to a watchdog or software reset are still there afterwards. A BOOT event
+** marks each start.
+*/
+namespace EventLog {
+    enum Level_t : uint8_t {LEVEL_ERROR, LEVEL_WARN, LEVEL_INFO, LEVEL_DEBUG, NUM_LEVELS};
+
+    // The ID is stored in the ring. Add new events at the end
+    enum Event_t : uint8_t {
+        BOOT,               // a: SRC_SRSR reset reason
+        ES100_LISTEN,
+        ES100_SHUTDOWN,
+        ES100_IRQ,          // a: irq status register
+        ES100_WRITE_FAILED, // a: register b: Wire.endTransmission() result
+        ES100_WRITE_OK,     // after a failure
+        ES100_READ_FAILED,  // a: register
+        WWVB_SYNC,          // a: UTC b: RTC error in seconds
+        WWVB_SEARCH,
+        RADIO_SILENCE,      // a: 1 begins, 0 ends
+        RADIO_ACK,          // a: sender b: msec in sendAckTo
+        RADIO_LOOP_DELAY,   // a: msec from receiving an ACK request to the next PacketWeather::loop
+        SENSOR_TEMPERATURE, // a: sender b: hundredths C
+        SENSOR_RAIN,        // a: sender b: tips counted
+        CPU_LEVEL,          // a: ClockGovernor::Level_t
+        ES100_BUS_RECOVERY, // a: 1 bus idle afterwards, 0 still stuck b: usec
+        TRANSMIT_QUEUED,    // a: destination b: seq
+        TRANSMIT_DONE,      // a: seq b: TransmitQueue::Status_t
+        RADIO_AWAKE,        // a: 1 awake, 0 asleep
+        RAINGAUGE_DELTA,    // a: sender b: F change since the last counted report
+        ES100_DST,          // a: status0 DST and RXOK bits b: isDstNow()
+        ES100_DST_BEGINS,   // a: UTC midnight of the day b: local hour
+        ES100_DST_ENDS,     // a: UTC midnight of the day b: local hour
+        NUM_EVENTS};
+
+    const uint16_t CAPACITY = 1024; // a power of 2
+
+    void setup(uint32_t resetReason);
+    // Events less severe than the level aren't recorded. The second argument is 16 bits
+    void setLevel(Level_t);
+    Level_t level();
+    void log(Event_t, int32_t a = 0, int32_t b = 0);
+    // echo new events to Serial. Call at idle time
+    void loop();
+    // print the newest count events, oldest first
+    void dump(uint16_t count = CAPACITY);
+    const char *levelName(Level_t);
+    bool levelFromChar(char, Level_t &);
+    // for MemoryReport
+    const void *ringAddress();
+    uint32_t ringBytes();
+}
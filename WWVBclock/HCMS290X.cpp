@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include "HCMS290X.h"
+#include "SpiBus.h"
 #include "WwvbClockDefinitions.h"
 
 /*
@@ -63,31 +64,31 @@ void Hcms290X<DualDisplay>::setup(bool enable)
 
     DEBUG_OUTPUT1(F("Hcms290X::setup()\n"));
 
-    SPI.beginTransaction(spiUprightSettings);
+    SpiBus::beginTransaction(SpiBus::LED, spiUprightSettings);
     digitalWrite(nEnablePin, LOW); // latches regSelPin as CONTROL register
     
     uint8_t control1 = (1 << CONTROL_WORD_1_BIT) | (1 << CONTROL_WORD_1_SIMUL_BIT);
-    SPI.transfer(control1);
+    SpiBus::transfer(control1);
     if (DualDisplay > SINGLE_ROW_OF_FOUR) // if there are two ICs, set the second one to match control writes with the first
-        SPI.transfer(control1);
-    SPI.transfer(control1);
+        SpiBus::transfer(control1);
+    SpiBus::transfer(control1);
     delayMicroseconds(1);
     digitalWrite(nEnablePin, HIGH); // IC transfers our control word to its internal  
-    SPI.endTransaction();
+    SpiBus::endTransaction(SpiBus::LED);
 
     // clear the DOT register
     delayMicroseconds(1);
     digitalWrite(regSelPin, LOW);
     delayMicroseconds(1);
-    SPI.beginTransaction(spiUprightSettings);
+    SpiBus::beginTransaction(SpiBus::LED, spiUprightSettings);
     digitalWrite(nEnablePin, LOW); // latches regSelPin as DOT register
         for (uint8_t i = 0; i < DISPLAY_WIDTH; i ++)
           for (uint8_t j = 0; j < Raster5x7Font::RASTER_BYTES_PER_CHARACTER; j++)
-                SPI.transfer(0);
+                SpiBus::transfer(0);
 
     delayMicroseconds(1);
     digitalWrite(nEnablePin, HIGH); // IC transfers our control word to its internal  
-    SPI.endTransaction();
+    SpiBus::endTransaction(SpiBus::LED);
 }
 
 template <LED_Hardware_e DualDisplay>
@@ -107,15 +108,15 @@ void Hcms290X<DualDisplay>::setupDevice(bool sleep, LED_Current_t led, uint8_t p
     m_sleep = sleep;
     digitalWrite(regSelPin, HIGH);
     delayMicroseconds(1);
-    SPI.beginTransaction(spiUprightSettings);
+    SpiBus::beginTransaction(SpiBus::LED, spiUprightSettings);
     digitalWrite(nEnablePin, LOW); // latches regSelPin as CONTROL register
     uint8_t control0 = (sleep ? 0 : (1 << SLEEP_MODE_BIT) ) |
                 static_cast<uint8_t>(led) |
                 (0xf & pwm);
-    SPI.transfer(control0);
+    SpiBus::transfer(control0);
     delayMicroseconds(1);
     digitalWrite(nEnablePin, HIGH); // IC transfers our control word to its internal  
-    SPI.endTransaction();
+    SpiBus::endTransaction(SpiBus::LED);
     digitalWrite(blankingPin, m_sleep ? HIGH : LOW);
 }
 
@@ -205,7 +206,7 @@ void Hcms290X<DualDisplay>::displayString(const char *p, bool rightJustify)
     digitalWrite(regSelPin, LOW);
     delayMicroseconds(1);
     SPISettings spiSettings(SPI_CLOCK, m_rotate180 ? LSBFIRST : MSBFIRST,SPI_MODE);
-    SPI.beginTransaction(spiSettings);
+    SpiBus::beginTransaction(SpiBus::LED, spiSettings);
     digitalWrite(nEnablePin, LOW); // latches regSelPin as DOT register
 
     if (!m_rotate180)
@@ -218,7 +219,7 @@ void Hcms290X<DualDisplay>::displayString(const char *p, bool rightJustify)
                 if (k >= NUM_RASTERS)
                     k -= NUM_RASTERS;
                 auto rin = rasters[k++];
-                SPI.transfer(rin);
+                SpiBus::transfer(rin);
             }
         }
     }
@@ -236,13 +237,13 @@ void Hcms290X<DualDisplay>::displayString(const char *p, bool rightJustify)
                     k += NUM_RASTERS;
                 auto r = rasters[k--];
                 r <<= 1; // its really a 7 bit raster
-                SPI.transfer(r);
+                SpiBus::transfer(r);
             }
     }
 
     delayMicroseconds(1);
     digitalWrite(nEnablePin, HIGH); 
-    SPI.endTransaction();
+    SpiBus::endTransaction(SpiBus::LED);
 }
 
 template <LED_Hardware_e DualDisplay>
@@ -0,0 +1,156 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "Journal.h"
+#include "Crc16.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    // ORDER MUST MATCH Journal::Key_t
+    const char * const KEY_NAMES[Journal::NUM_KEYS] =
+    { "DstInEffect", "RainToday", "RainYesterday", "RainUtc", "LastSyncUtc", "DriftErrorSeconds", "DriftIntervalSeconds" };
+}
+
+Journal::Journal()
+    : m_start(0)
+    , m_slots(0)
+    , m_next(0)
+    , m_sequence(0)
+    , m_slotOf()
+    , m_values()
+    , m_writes(0)
+    , m_copies(0)
+    , m_skips(0)
+{
+    for (auto &s : m_slotOf)
+        s = -1;
+}
+
+uint8_t Journal::check(const Record &r)
+{
+    Record c = r;
+    c.check = 0;
+    return static_cast<uint8_t>(crc16(&c, sizeof(c)));
+}
+
+uint8_t Journal::setup(uint16_t start, uint16_t end)
+{
+    m_start = start;
+    m_slots = (end - start) / sizeof(Record);
+    if (m_slots <= 2 * NUM_KEYS)
+    {   // too small to carry every key forward. See write()
+        m_slots = 0;
+        return 0;
+    }
+    uint16_t keySequence[NUM_KEYS] = {};
+    bool any = false;
+    uint16_t newest = 0;
+    for (uint16_t slot = 0; slot < m_slots; slot++)
+    {
+        Record r;
+        EEPROM.get(m_start + slot * sizeof(Record), r);
+        if (r.key >= NUM_KEYS || r.check != check(r))
+            continue; // erased, or torn by a power failure
+        // the ring holds consecutive sequence numbers, so compare them the way TCP does
+        if (!any || static_cast<int16_t>(r.sequence - m_sequence) > 0)
+        {
+            m_sequence = r.sequence;
+            newest = slot;
+            any = true;
+        }
+        if (m_slotOf[r.key] < 0 || static_cast<int16_t>(r.sequence - keySequence[r.key]) > 0)
+        {
+            keySequence[r.key] = r.sequence;
+            m_slotOf[r.key] = slot;
+            m_values[r.key] = r.value;
+        }
+    }
+    uint8_t recovered = 0;
+    for (auto s : m_slotOf)
+        if (s >= 0)
+            recovered += 1;
+    m_next = any ? (newest + 1) % m_slots : 0;
+    m_sequence += 1;
+    return recovered;
+}
+
+void Journal::append(Key_t key, int32_t value)
+{
+    Record r;
+    r.sequence = m_sequence++;
+    r.key = key;
+    r.value = value;
+    r.check = check(r);
+    EEPROM.put(m_start + m_next * sizeof(Record), r);
+    m_slotOf[key] = m_next;
+    m_values[key] = value;
+    m_next = (m_next + 1) % m_slots;
+    m_writes += 1;
+}
+
+void Journal::write(Key_t key, int32_t value)
+{
+    if (m_slots == 0 || key >= NUM_KEYS)
+        return;
+    if (has(key) && m_values[key] == value)
+        return;
+    /* The head never overwrites the only record of any key, so a torn write loses
+    ** nothing. It steps over each such record, and another key's is then copied
+    ** to the next free slot, leaving the old one to be overwritten next time around.
+    ** At most NUM_KEYS are stepped over and NUM_KEYS - 1 copied, and m_slots > 2 * NUM_KEYS,
+    ** so the head does not come back around to what it just wrote. */
+    uint8_t toCopy = 0; // bit per key
+    for (;;)
+    {
+        int8_t only = -1;
+        for (uint8_t k = 0; k < NUM_KEYS; k++)
+            if (m_slotOf[k] == m_next)
+                only = static_cast<int8_t>(k);
+        if (only >= 0)
+        {
+            if (only != key)
+                toCopy |= 1 << only;
+            m_next = (m_next + 1) % m_slots;
+            m_skips += 1;
+            continue;
+        }
+        if (toCopy == 0)
+            break;
+        uint8_t k = 0;
+        while (0 == (toCopy & (1 << k)))
+            k += 1;
+        toCopy &= ~(1 << k);
+        append(static_cast<Key_t>(k), m_values[k]);
+        m_copies += 1;
+    }
+    append(key, value);
+}
+
+void Journal::print() const
+{
+#if USE_SERIAL
+    Serial.print(F("Journal slots="));
+    Serial.print(m_slots);
+    Serial.print(F(" next="));
+    Serial.print(m_next);
+    Serial.print(F(" sequence="));
+    Serial.print(m_sequence);
+    Serial.print(F(" writes since power up="));
+    Serial.print(m_writes);
+    Serial.print(F(" of which copies="));
+    Serial.print(m_copies);
+    Serial.print(F(" skips="));
+    Serial.println(m_skips);
+    for (uint8_t k = 0; k < NUM_KEYS; k++)
+    {
+        Serial.print(F("  "));
+        Serial.print(KEY_NAMES[k]);
+        if (!has(static_cast<Key_t>(k)))
+        {
+            Serial.println(F(" none"));
+            continue;
+        }
+        Serial.print('=');
+        Serial.println(m_values[k]);
+    }
+#endif
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+
+/* Journal keeps runtime state that changes far more often than the settings,
+** so that it survives a power cycle.
+**
+** Its EEPROM region is a ring of fixed size records, each holding a key, a value
+** and a sequence number, checked by a CRC byte. write() appends at the head of
+** the ring rather than rewriting the key's previous record, so the writes are
+** spread over the whole region. The head steps over the only record of any key,
+** and another key's is then copied forward, so the ring holds every key within
+** about one lap of sequence numbers.
+** setup() replays the ring: the newest record of each key wins. A record torn by
+** a power failure fails its check and is ignored, leaving the key's previous value,
+** because no write ever overwrites the only record of a key.
+**
+** The JournalSim host program runs this file over an array in place of EEPROM.
+*/
+class Journal {
+    public:
+        enum Key_t : uint8_t {
+            DST_IN_EFFECT,
+            RAIN_TODAY,             // hundredths of mm, before correction
+            RAIN_YESTERDAY,
+            RAIN_UTC,               // when the two above were written
+            LAST_SYNC_UTC,          // last WWVB sync
+            DRIFT_ERROR_SECONDS,    // Telemetry drift sums
+            DRIFT_INTERVAL_SECONDS,
+            NUM_KEYS};
+
+        Journal();
+        // uses EEPROM from start up to end. Returns the number of keys recovered
+        uint8_t setup(uint16_t start, uint16_t end);
+        bool has(Key_t k) const { return m_slotOf[k] >= 0; }
+        int32_t value(Key_t k) const { return m_values[k]; }
+        // does nothing if value is what the journal already holds
+        void write(Key_t, int32_t value);
+        void print() const;
+
+    protected:
+        struct Record {
+            uint16_t sequence;
+            uint8_t key;
+            uint8_t check;
+            int32_t value;
+        };
+        static uint8_t check(const Record &);
+        void append(Key_t, int32_t);
+        uint16_t m_start;
+        uint16_t m_slots; // more than 2 * NUM_KEYS, or zero
+        uint16_t m_next;
+        uint16_t m_sequence;
+        int16_t m_slotOf[NUM_KEYS]; // -1 if none
+        int32_t m_values[NUM_KEYS];
+        uint32_t m_writes;
+        uint32_t m_copies;
+        uint32_t m_skips;
+};
@@ -0,0 +1,187 @@
+#include <Arduino.h>
+#include "LoopMonitor.h"
+#include "NoInit.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    // tells setup() which probe was running when the WDOG fired
+    struct LastProbe {
+        uint8_t probe;
+        uint8_t check; // ~probe
+    };
+    const uint32_t LAST_PROBE_MAGIC = 0x4C6F6F70ul;
+    DMAMEM NoInit<LastProbe, LAST_PROBE_MAGIC> lastProbe;
+
+    // SRC_SRSR bits, in order from bit zero
+    const char * const RESET_NAMES[] = { "power on", "software/lockup", "CSU", "reset pin", "WDOG1",
+        "JTAG", "JTAG software", "WDOG3", "temperature" };
+    const uint8_t NUM_RESET_NAMES = sizeof(RESET_NAMES) / sizeof(RESET_NAMES[0]);
+
+    void writeLastProbe(uint8_t v)
+    {
+        lastProbe.data.probe = v;
+        lastProbe.data.check = ~v;
+        lastProbe.flush(lastProbe.data);
+    }
+}
+
+LoopMonitor::LoopMonitor(const char * const *probeNames, uint8_t numProbes)
+    : m_probeNames(probeNames)
+    , m_numProbes(numProbes)
+    , m_resetReason(0)
+    , m_probeBeforeReset(NO_PROBE)
+    , m_watchdogRunning(false)
+    , m_budgetMsec(MAX_BUDGET_MSEC)
+    , m_probe(NO_PROBE)
+    , m_slowProbe(NO_PROBE)
+    , m_slowProbeUsec(0)
+    , m_loopBeganUsec(0)
+    , m_probeBeganUsec(0)
+    , m_worstUsec(0)
+    , m_worstProbe(NO_PROBE)
+    , m_worstProbeUsec(0)
+    , m_overBudget(0)
+    , m_histogram()
+{}
+
+void LoopMonitor::setup()
+{
+#if defined(__IMXRT1062__)
+    m_resetReason = SRC_SRSR;
+    SRC_SRSR = m_resetReason; // write ones to clear, so the next reset reports only itself
+#endif
+    const auto &last = lastProbe.data;
+    if (lastProbe.valid() && last.check == static_cast<uint8_t>(~last.probe))
+        m_probeBeforeReset = last.probe;
+    lastProbe.claim();
+    writeLastProbe(NO_PROBE);
+}
+
+uint8_t LoopMonitor::timeoutSeconds() const
+{   // twice the budget, so a pass a little over budget is only counted
+    return static_cast<uint8_t>((2ul * m_budgetMsec + 999) / 1000);
+}
+
+void LoopMonitor::setBudget(uint16_t msec)
+{
+    if (msec < MIN_BUDGET_MSEC)
+        msec = MIN_BUDGET_MSEC;
+    if (msec > MAX_BUDGET_MSEC)
+        msec = MAX_BUDGET_MSEC;
+    m_budgetMsec = msec;
+#if defined(__IMXRT1062__)
+    if (!m_watchdogRunning)
+    {
+        CCM_CCGR3 |= CCM_CCGR3_WDOG1(CCM_CCGR_ON);
+        WDOG1_WMCR = 0; // else the power down counter asserts WDOG_B 16 seconds after reset
+    }
+    // time out is (WT + 1) half seconds. SRS and WDA are written as 1 because 0 asserts a reset
+    WDOG1_WCR = WDOG_WCR_WDZST | WDOG_WCR_WT(2 * timeoutSeconds() - 1) | WDOG_WCR_WDE | WDOG_WCR_SRS | WDOG_WCR_WDA;
+    WDOG1_WSR = 0x5555;
+    WDOG1_WSR = 0xAAAA;
+#endif
+    m_watchdogRunning = true;
+}
+
+void LoopMonitor::beginLoop()
+{
+    m_loopBeganUsec = micros();
+    m_probeBeganUsec = m_loopBeganUsec;
+    m_probe = NO_PROBE;
+    m_slowProbe = NO_PROBE;
+    m_slowProbeUsec = 0;
+}
+
+void LoopMonitor::probe(uint8_t v)
+{
+    auto now = micros();
+    uint32_t usec = now - m_probeBeganUsec;
+    if (m_probe != NO_PROBE && usec >= m_slowProbeUsec)
+    {
+        m_slowProbe = m_probe;
+        m_slowProbeUsec = usec;
+    }
+    m_probe = v;
+    m_probeBeganUsec = now;
+    writeLastProbe(v);
+}
+
+void LoopMonitor::endLoop()
+{
+    probe(NO_PROBE);
+    uint32_t usec = m_probeBeganUsec - m_loopBeganUsec;
+    uint8_t bucket = usec == 0 ? 0 : 32 - __builtin_clz(usec);
+    if (bucket >= NUM_BUCKETS)
+        bucket = NUM_BUCKETS - 1;
+    m_histogram[bucket] += 1;
+    if (usec > m_worstUsec)
+    {
+        m_worstUsec = usec;
+        m_worstProbe = m_slowProbe;
+        m_worstProbeUsec = m_slowProbeUsec;
+    }
+    if (usec > m_budgetMsec * 1000ul)
+    {
+        m_overBudget += 1;
+        return;
+    }
+#if defined(__IMXRT1062__)
+    if (m_watchdogRunning)
+    {
+        WDOG1_WSR = 0x5555;
+        WDOG1_WSR = 0xAAAA;
+    }
+#endif
+}
+
+const char *LoopMonitor::probeName(uint8_t v) const
+{
+    return v < m_numProbes ? m_probeNames[v] : "none";
+}
+
+void LoopMonitor::print() const
+{
+#if USE_SERIAL
+    Serial.print(F("Reset reason:"));
+    for (uint8_t i = 0; i < NUM_RESET_NAMES; i++)
+        if (m_resetReason & (1ul << i))
+        {
+            Serial.print(' ');
+            Serial.print(RESET_NAMES[i]);
+        }
+    Serial.print(F(". Probe running before reset: "));
+    Serial.println(probeName(m_probeBeforeReset));
+    Serial.print(F("Loop budget msec="));
+    Serial.print(m_budgetMsec);
+    Serial.print(F(" watchdog seconds="));
+    if (m_watchdogRunning)
+        Serial.print(timeoutSeconds());
+    else
+        Serial.print(F("off"));
+    Serial.print(F(" over budget="));
+    Serial.println(m_overBudget);
+    Serial.print(F("Worst loop usec="));
+    Serial.print(m_worstUsec);
+    Serial.print(F(" slowest probe in it: "));
+    Serial.print(probeName(m_worstProbe));
+    Serial.print(F(" usec="));
+    Serial.println(m_worstProbeUsec);
+    for (uint8_t i = 0; i < NUM_BUCKETS; i++)
+    {
+        if (m_histogram[i] == 0)
+            continue;
+        if (i == NUM_BUCKETS - 1)
+        {
+            Serial.print(F("  usec >= "));
+            Serial.print(1ul << (i - 1));
+        }
+        else
+        {
+            Serial.print(F("  usec < "));
+            Serial.print(1ul << i);
+        }
+        Serial.print(F(": "));
+        Serial.println(m_histogram[i]);
+    }
+#endif
+}
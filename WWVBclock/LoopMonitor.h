@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+
+/* LoopMonitor times each pass of loop() into a log2 histogram and keeps the
+** worst one, with the probe that took longest in it. loop() calls probe() as it
+** enters each subsystem.
+**
+** It also runs the i.MX RT WDOG1. endLoop() feeds the watchdog only when the
+** pass came in under the budget, so one slow pass is only counted, but a hang
+** in a Wire1 transaction or a radio retry resets the Teensy after
+** timeoutSeconds(). The WDOG can't be turned off again once started.
+**
+** The probe running at the time is kept in RAM that survives the reset, and
+** setup() reports it along with the reset reason from the SRC.
+*/
+class LoopMonitor {
+    public:
+        enum {NUM_BUCKETS = 24, NO_PROBE = 0xFF};
+        static const uint16_t MIN_BUDGET_MSEC = 100;
+        static const uint16_t MAX_BUDGET_MSEC = 30000;
+
+        // probeNames has numProbes entries, indexed by the argument to probe()
+        LoopMonitor(const char * const *probeNames, uint8_t numProbes);
+        // call early in setup(). Reads the reset reason and the last probe before the reset
+        void setup();
+        // starts the WDOG the first time
+        void setBudget(uint16_t msec);
+        void beginLoop();
+        void probe(uint8_t);
+        // feeds the WDOG if the pass was within budget
+        void endLoop();
+        uint8_t timeoutSeconds() const;
+        uint32_t resetReason() const { return m_resetReason; }
+        void print() const;
+
+    protected:
+        const char *probeName(uint8_t) const;
+        const char * const * const m_probeNames;
+        const uint8_t m_numProbes;
+        uint32_t m_resetReason; // SRC_SRSR
+        uint8_t m_probeBeforeReset;
+        bool m_watchdogRunning;
+        uint16_t m_budgetMsec;
+        uint8_t m_probe;
+        uint8_t m_slowProbe;
+        uint32_t m_slowProbeUsec;
+        unsigned long m_loopBeganUsec;
+        unsigned long m_probeBeganUsec;
+        uint32_t m_worstUsec;
+        uint8_t m_worstProbe;
+        uint32_t m_worstProbeUsec;
+        uint32_t m_overBudget;
+        uint32_t m_histogram[NUM_BUCKETS];
+};
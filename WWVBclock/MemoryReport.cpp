@@ -0,0 +1,116 @@
+#include <Arduino.h>
+#include "MemoryReport.h"
+#include "WwvbClockDefinitions.h"
+
+#if defined(__IMXRT1062__)
+// Teensy 4 linker script, imxrt1062.ld
+extern unsigned long _stext, _etext, _sdata, _edata, _sbss, _ebss, _estack;
+extern unsigned long _heap_start, _heap_end, _flashimagelen, _itcm_block_count;
+extern "C" char *sbrk(int incr);
+#endif
+
+namespace MemoryReport {
+namespace {
+    const uint32_t PAINT = 0xA5A5A5A5ul;
+    const uint32_t PAINT_MARGIN_BYTES = 256; // below the stack pointer in paintStack()
+
+    struct Region {
+        const char *name;
+        uint32_t begin;
+        uint32_t end;
+    };
+    const Region REGIONS[] = {
+        { "ITCM", 0x00000000ul, 0x00080000ul },
+        { "DTCM", 0x20000000ul, 0x20080000ul },
+        { "OCRAM", 0x20200000ul, 0x20280000ul },
+        { "FLASH", 0x60000000ul, 0x70000000ul },
+    };
+
+#if USE_SERIAL
+    void printBytes(const __FlashStringHelper *name, uint32_t used, uint32_t total)
+    {
+        Serial.print(F("  "));
+        Serial.print(name);
+        Serial.print(F(" used="));
+        Serial.print(used);
+        Serial.print(F(" free="));
+        Serial.println(total - used);
+    }
+#endif
+}
+
+void paintStack()
+{
+#if defined(__IMXRT1062__)
+    uint32_t here;
+    auto p = reinterpret_cast<volatile uint32_t *>(&_ebss);
+    auto end = reinterpret_cast<volatile uint32_t *>(reinterpret_cast<char *>(&here) - PAINT_MARGIN_BYTES);
+    while (p < end)
+        *p++ = PAINT;
+#endif
+}
+
+uint32_t stackHighWaterBytes()
+{
+#if defined(__IMXRT1062__)
+    auto p = reinterpret_cast<const uint32_t *>(&_ebss);
+    auto top = reinterpret_cast<const uint32_t *>(&_estack);
+    while (p < top && *p == PAINT)
+        p += 1;
+    return reinterpret_cast<const char *>(top) - reinterpret_cast<const char *>(p);
+#else
+    return 0;
+#endif
+}
+
+const char *regionName(const void *address)
+{
+    auto a = reinterpret_cast<uintptr_t>(address);
+    for (const auto &r : REGIONS)
+        if (a >= r.begin && a < r.end)
+            return r.name;
+    return "?";
+}
+
+void print(const Static *statics, uint8_t count)
+{
+#if USE_SERIAL && defined(__IMXRT1062__)
+    auto addr = [](const void *p) { return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(p)); };
+    Serial.println(F("Memory bytes:"));
+    printBytes(F("ITCM code"), addr(&_etext) - addr(&_stext), 32768ul * addr(&_itcm_block_count));
+    uint32_t dtcm = addr(&_estack) - REGIONS[1].begin;
+    Serial.print(F("  DTCM data="));
+    Serial.print(addr(&_edata) - addr(&_sdata));
+    Serial.print(F(" bss="));
+    Serial.print(addr(&_ebss) - addr(&_sbss));
+    Serial.print(F(" stack high water="));
+    Serial.print(stackHighWaterBytes());
+    Serial.print(F(" never used="));
+    Serial.print(dtcm - (addr(&_ebss) - REGIONS[1].begin) - stackHighWaterBytes());
+    Serial.println();
+    uint32_t heapTop = addr(sbrk(0));
+    Serial.print(F("  OCRAM DMAMEM="));
+    Serial.print(addr(&_heap_start) - REGIONS[2].begin);
+    Serial.print(F(" heap="));
+    Serial.print(heapTop - addr(&_heap_start));
+    Serial.print(F(" free="));
+    Serial.println(addr(&_heap_end) - heapTop);
+    Serial.print(F("  FLASH image="));
+    Serial.println(addr(&_flashimagelen));
+    Serial.println(F("Large statics:"));
+    for (uint8_t i = 0; i < count; i++)
+    {
+        Serial.print(F("  "));
+        Serial.print(statics[i].name);
+        Serial.print(' ');
+        Serial.print(statics[i].bytes);
+        Serial.print(' ');
+        Serial.println(regionName(statics[i].address));
+    }
+#else
+    (void)statics;
+    (void)count;
+#endif
+}
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+
+/* MemoryReport shows where the Teensy 4's RAM goes.
+**
+**      ITCM    code copied from flash to run fast. Allocated in 32KB blocks
+**      DTCM    initialized data, which includes const tables not marked PROGMEM,
+**              then zeroed statics, then the stack growing down from the top
+**      OCRAM   DMAMEM statics, then the heap
+**      FLASH   the program image, and PROGMEM data read in place
+**
+** paintStack() fills the unused stack with a pattern at boot. The stack's high
+** water mark is the lowest address where the pattern has since been overwritten.
+*/
+namespace MemoryReport {
+    struct Static {
+        const char *name;
+        const void *address;
+        uint32_t bytes;
+    };
+
+    // call first thing in setup()
+    void paintStack();
+    uint32_t stackHighWaterBytes();
+    const char *regionName(const void *);
+    void print(const Static *statics, uint8_t count);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/* NoInit holds data that outlives a reset short of a power cycle: a watchdog,
+** a fault, or a software restart. Define it DMAMEM, which the startup code
+** doesn't clear:
+**      DMAMEM NoInit<Ring, RING_MAGIC> ring;
+** After a power up, or a build with a different layout, it holds whatever was
+** there, so valid() checks the magic. Fold a size or version into MAGIC. The owner
+** checks its own data as well, and calls claim() once it has read what was left.
+**
+** DMAMEM is behind the data cache, and a reset loses whatever the cache hasn't
+** written back, so pass each write that must survive one to flush().
+*/
+template <typename T, uint32_t MAGIC>
+struct NoInit {
+    uint32_t magic;
+    T data;
+
+    bool valid() const { return magic == MAGIC; }
+
+    void claim()
+    {
+        magic = MAGIC;
+        flush(magic);
+    }
+
+    // v is this, or any part of it. bytes defaults to all of v
+    template <typename U>
+    static void flush(const U &v, size_t bytes = sizeof(U))
+    {
+        arm_dcache_flush(const_cast<U *>(&v), bytes);
+    }
+};
@@ -2,45 +2,23 @@
 #include <RFM69registers.h>
 #include "PacketWeather.h"
 #include "WWVBclock.h"
+#include "BinaryCommand.h"
+#include "EventLog.h"
 #include "WwvbClockDefinitions.h"
 
 #define MONITOR_RSSI
 
 namespace { 
     const uint8_t GATEWAY_NODEID = 1;
-    char reportbuf[sizeof(RFM69::DATA) + 1];
-    const float NO_DATA = -999.9;
 
-    float parseForColon(char flag, const char* p, uint8_t len)
-    {   // help parse the Wireless Thermometer packet
-        uint8_t c = len;
-        for (;;)
-        {
-            if (!*p)
-                return NO_DATA;
-            if (c == 0)
-                return NO_DATA;
-            if (p[0] == flag && p[1] == ':')
-            {
-                p += 2;  c -= 2;
-                return atof(p);
-            } else
-            {
-                p += 1;
-                c -= 1;
-            }
-        }
-        return NO_DATA;
-    }
+    const int16_t NO_RAINGAUGE_F = 0x7FFF; // far away from expected responses
 }
  
 PacketWeather::PacketWeather(int nSS_pin, int int_Pin) 
     : radio(nSS_pin, int_Pin)
+    , m_transmit(radio)
     , radioSetupOK(false)
-    , m_prevRgF(0x7FFF) // far away from expected responses
-    , indoorTemperatureSensorMask(0)
-    , outdoorTemperatureSensorMask(0)
-    , raingaugeSensorMask(0)
+    , m_awake(true)
     , m_monitorRSSI(false)
     , m_sleepBegan(millis())
     , m_clock(0)
@@ -65,6 +43,8 @@ void PacketWeather::setup()
                 radio.setFrequency(freq*1000);
             radio.spyMode(true);
             radioSetupOK = radio.getFrequency() != 0;
+            if (radioSetupOK)
+                radio.startQueue(radioConfiguration.NodeId());
         }
 #if USE_SERIAL
 #endif
@@ -129,95 +109,90 @@ bool PacketWeather::ProcessCommand(const char* cmd, uint8_t len, uint8_t senderi
         if (strncmp(q, "R ", 2) == 0)
         {
             q += 2;
-            DEBUG_STATEMENT( bool status = )
-                 radio.sendWithRetry(GATEWAY_NODEID, q, strlen(q)+1);
-            DEBUG_OUTPUT1("SendGateway status ");
-            DEBUG_OUTPUT1(status ? "ACK" : "NAK");
-            DEBUG_OUTPUT1('\n');
+            auto seq = m_transmit.enqueue(GATEWAY_NODEID, q, strlen(q)+1, true);
+            EventLog::log(EventLog::TRANSMIT_QUEUED, GATEWAY_NODEID, seq);
         }
         else
-            radio.send(GATEWAY_NODEID, q, strlen(q)+1);
+            m_transmit.enqueue(GATEWAY_NODEID, q, strlen(q)+1, false);
         return true;
     }
  
-    static const int MAX_SENDER_ID = 32;
-    if (senderid <= MAX_SENDER_ID && senderid > 0)
-    {   // is this a weather sensor we have been asked to monitor?
-        uint32_t mask = 1L << (senderid-1);
-        if (0 != (mask & (indoorTemperatureSensorMask | outdoorTemperatureSensorMask)))
-        {
-             // Example thermometers:
-            //      C:49433, B:244, T:+20.37
-            //      C:1769, B:198, T:+20.58 R:45.46
-            auto tCx10 = parseForColon('T', cmd, len);
-            if (tCx10 == NO_DATA)
-                return false;
-            if (m_clock)
-            {
-                if (0 != (mask & indoorTemperatureSensorMask))
-                    m_clock->notifyIndoorTemp(tCx10);
-                else if (0 != (mask & outdoorTemperatureSensorMask))
-                    m_clock->notifyOutdoorTemp(tCx10);
-            }
-            DEBUG_OUTPUT1(F("received temperature. id="));
-            DEBUG_OUTPUT1(static_cast<int>(senderid));
-            DEBUG_OUTPUT1(F(" tCx10="));
-            DEBUG_OUTPUT1(tCx10);
-            DEBUG_OUTPUT1('\n');
-            //int16_t rhx10 = parseForColon('R', cmd, len);
-        }
-        else if (mask & raingaugeSensorMask)
-        {
-            DEBUG_OUTPUT1(F("received rainguage. id="));
-            DEBUG_OUTPUT1(static_cast<int>(senderid));
-            DEBUG_OUTPUT1(F(" string='"));
-            DEBUG_OUTPUT1(cmd);
-            DEBUG_OUTPUT1('\'');
-            const char *isF = strstr(cmd, " F: ");
-            const char *isRG = strstr(cmd, " RG: ");
-            if (isF != 0 && isRG != 0)
-            {
-                auto rg = atoi(isRG + 5);
-                if (rg != 0)
-                {
-                    auto f = atoi(isF + 4);
-                    int16_t diffF = m_prevRgF - f;
-                    DEBUG_OUTPUT1(" m_prevRgF=");
-                    DEBUG_OUTPUT1(m_prevRgF);
-                    DEBUG_OUTPUT1(" diffF=");
-                    DEBUG_OUTPUT1(diffF);
-                    if (diffF < 0)
-                        diffF = -diffF;
-                    if (diffF >= 1000)
-                    {   // 1000 is magic number. that is what the Silicon Labs magnetometer reads
-                        m_prevRgF = f;
-                        if (m_clock)
-                            m_clock->notifyRainmm(rg);
-                    }
-                }
-                else
-                    return false;
-            }
-            else
-                return false;
-            DEBUG_OUTPUT1('\n');      
-        }
+    return false;
+}
+
+// ORDER MUST MATCH SensorRegistry::Role_t
+const PacketWeather::SensorHandler_t PacketWeather::SENSOR_HANDLERS[SensorRegistry::NUM_ROLES] =
+{
+    nullptr,
+    &PacketWeather::onThermometer,
+    &PacketWeather::onThermometer,
+    &PacketWeather::onRaingauge,
+};
+
+bool PacketWeather::isSensor(unsigned senderid) const
+{   // is this a weather sensor we have been asked to monitor?
+    return senderid < SensorRegistry::NUM_NODE_IDS && 
+        m_sensors.role(static_cast<uint8_t>(senderid)) != SensorRegistry::ROLE_NONE;
+}
+
+bool PacketWeather::processSensorPacket(uint8_t senderid, const uint8_t *p, uint8_t len)
+{
+    auto handler = SENSOR_HANDLERS[m_sensors.role(senderid)];
+    if (!handler)
+        return false;
+    SensorFields fields;
+    fields.parse(p, len);
+    return (this->*handler)(senderid, fields);
+}
+
+bool PacketWeather::onThermometer(uint8_t senderid, const SensorFields &fields)
+{
+    if (!fields.has(SensorFields::T))
+        return false;
+    auto tCx100 = m_sensors.calibrated(senderid, fields.x100[SensorFields::T]);
+    m_sensors.seen(senderid, tCx100);
+    if (m_clock)
+    {
+        if (m_sensors.role(senderid) == SensorRegistry::ROLE_INDOOR_TEMP)
+            m_clock->notifyIndoorTemp(tCx100 / 100.f);
         else
-            return false;
-        return true;
+            m_clock->notifyOutdoorTemp(tCx100 / 100.f);
     }
-    return false;
+    EventLog::log(EventLog::SENSOR_TEMPERATURE, senderid, tCx100);
+    return true;
+}
+
+bool PacketWeather::onRaingauge(uint8_t senderid, const SensorFields &fields)
+{
+    if (!fields.has(SensorFields::F) || !fields.has(SensorFields::RG))
+        return false;
+    auto rg = fields.integer(SensorFields::RG);
+    if (rg == 0)
+        return false;
+    auto &e = m_sensors.entry(senderid);
+    if (e.lastSeenMsec == 0)
+        e.aux = NO_RAINGAUGE_F;
+    auto f = fields.integer(SensorFields::F);
+    int16_t diffF = e.aux - f;
+    EventLog::log(EventLog::RAINGAUGE_DELTA, senderid, diffF);
+    if (diffF < 0)
+        diffF = -diffF;
+    if (diffF >= 1000)
+    {   // 1000 is magic number. that is what the Silicon Labs magnetometer reads
+        e.aux = f;
+        m_sensors.seen(senderid, e.lastValue + rg); // cumulative mm since power up
+        EventLog::log(EventLog::SENSOR_RAIN, senderid, rg);
+        if (m_clock)
+            m_clock->notifyRainmm(rg);
+    }
+    else
+        m_sensors.seen(senderid, e.lastValue);
+    return true;
 }
 
 #if defined(MONITOR_RSSI)
-namespace MonitorRSSI {
-    const int NUM_RSSI_PWR2 = 5;
-    const int NUM_RSSI_RECORDS = 1 << NUM_RSSI_PWR2;
-    const int MONITOR_RSSI_MSEC = 100;
-    const int PRINT_RSSI_MSEC = 2000;
-    int whichRssiRecord = 0;
-    int16_t rssiRecord[NUM_RSSI_RECORDS];
-    auto prevRssiRecord = millis();
+namespace {
+    const unsigned long PRINT_RSSI_MSEC = 2000;
     auto prevRssiPrint = millis();
 }
 #endif
@@ -231,97 +206,134 @@ void PacketWeather::loop()
     static auto stamp = millis();
     auto now = millis();
     #pragma GCC diagnostic pop
-    static bool printMillis = false;
-    if (printMillis)
+    static bool logDelay = false;
+    if (logDelay)
     {
-#if USE_SERIAL > 0
-        Serial.print(F("PacketWeather:loop delay msec="));
-        Serial.println(millis() - stamp);
-#endif
-        printMillis = false;
+        EventLog::log(EventLog::RADIO_LOOP_DELAY, millis() - stamp);
+        logDelay = false;
+    }
+    // ListenMode would miss the ACK to a message in m_transmit
+    radio.listenMode(m_transmit.idle());
+    if (m_awake)
+    {   // asleep, outgoing messages wait in m_transmit
+        m_transmit.loop(); // before poll(), which would discard a pending ACK
+        radio.poll();
     }
-     // check radio
-    if (radio.receiveDone()) // Got a packet over the radio
-    {   // RFM69 ensures no trailing zero byte when buffer is full
-        memset(reportbuf, 0, sizeof(reportbuf));
-        memcpy(reportbuf, &radio.DATA[0], sizeof(radio.DATA));
-        auto targetId = radio.TARGETID;
-        unsigned senderId = radio.SENDERID;
-        DEBUG_STATEMENT(auto rssi = radio.RSSI);
-        DEBUG_STATEMENT(int16_t rssi1 = radio.readRSSI());
-        bool toMe = radioConfiguration.NodeId() == targetId;
-        auto ackR = radio.ACKRequested();
-
-    #if defined(DEBUG_TO_SERIAL)
-        Serial.print('"');
-        Serial.print(reportbuf);
-        Serial.print("\" ");
-        Serial.print("Received. RSSI=");
-        Serial.print(rssi);
-        Serial.print(" now is: ");
-        Serial.print(rssi1);
-        Serial.print(" node:");
-        Serial.println(senderId);
-    #endif
-
-        if (toMe && ackR)
+    QueuedRFM69::Frame frame;
+    for (int i = 0; i < QueuedRFM69::QUEUE_LENGTH && radio.pop(frame); i++)
+    {
+        if (frame.ackRequested && frame.target == radioConfiguration.NodeId())
         {
             stamp = millis();
-            printMillis = true;
-            radio.sendACK();
-#if USE_SERIAL > 0
-            Serial.print("delay in SendACK ");
-            Serial.println(millis() - stamp);
-#endif
+            logDelay = true;
         }
-
-        routeCommand(reportbuf, sizeof(radio.DATA), static_cast<uint8_t>(senderId), toMe);
-     }
+        receivedFrame(frame);
+    }
 #if defined(MONITOR_RSSI)
-     if (now - MonitorRSSI::prevRssiRecord >= MonitorRSSI::MONITOR_RSSI_MSEC)
-     {
-        MonitorRSSI::rssiRecord[MonitorRSSI::whichRssiRecord++] = radio.readRSSI();
-        if (MonitorRSSI::whichRssiRecord >= MonitorRSSI::NUM_RSSI_RECORDS)
-            MonitorRSSI::whichRssiRecord = 0;
-        MonitorRSSI::prevRssiRecord = now;
-     }
+     if (m_awake && !radio.listening() && m_rssiSurvey.due(now, m_monitorRSSI))
+        m_rssiSurvey.sample(radio.readRSSI(), now);
 #if USE_SERIAL > 0
-     if (m_monitorRSSI && (now - MonitorRSSI::prevRssiPrint >= MonitorRSSI::PRINT_RSSI_MSEC))
+     if (m_monitorRSSI && (now - prevRssiPrint >= PRINT_RSSI_MSEC))
      {
-        MonitorRSSI::prevRssiPrint = now;
-        int32_t total = 0;
-        for (int i = 0; i < MonitorRSSI::NUM_RSSI_RECORDS; i += 1)
-            total += MonitorRSSI::rssiRecord[i];
-        total >>= MonitorRSSI::NUM_RSSI_PWR2;
-        uint16_t var = 0;
-        for (int i = 0; i < MonitorRSSI::NUM_RSSI_RECORDS; i += 1)
-        {
-            int16_t t = MonitorRSSI::rssiRecord[i] - total;
-            var += t * t;
-        }
+        prevRssiPrint = now;
+        const auto &w = m_rssiSurvey.window();
         Serial.print("RSSI AVG: ");
-        Serial.print(total);
+        Serial.print(w.mean, 1);
         Serial.print(" VAR: ");
-        Serial.println(var);
+        Serial.print(w.variance(), 1);
+        Serial.print(" FLOOR: ");
+        Serial.println(m_rssiSurvey.noiseFloor());
+        m_rssiSurvey.clearWindow();
      }
 #endif
 #endif
 }
 
+void PacketWeather::receivedFrame(const QueuedRFM69::Frame &frame)
+{   // RFM69 puts a zero byte after the frame's data
+    requestCpuBurst();
+    const char *payload = reinterpret_cast<const char *>(frame.data);
+    bool toMe = radioConfiguration.NodeId() == frame.target;
+    bool sensor = isSensor(frame.sender);
+
+#if defined(DEBUG_TO_SERIAL)
+    Serial.print('"');
+    Serial.print(payload);
+    Serial.print("\" ");
+    Serial.print("Received. RSSI=");
+    Serial.print(frame.rssi);
+    Serial.print(" node:");
+    Serial.println(frame.sender);
+#endif
+
+    if (sensor)
+    {   // parse in place
+        processSensorPacket(frame.sender, frame.data, frame.len); // logs what it found
+    }
+
+    // binary commands are applied before the ACK so their results can ride in it
+    uint8_t reply[RF69_MAX_DATA_LEN];
+    uint8_t replyLen = 0;
+    bool binary = toMe && !sensor && frame.len > 0 && frame.data[0] == BinaryCommand::MAGIC;
+    if (binary)
+        replyLen = routeBinaryCommand(frame.data, frame.len, reply, sizeof(reply));
+
+    if (toMe && frame.ackRequested && m_awake)
+    {
+        auto stamp = millis();
+        radio.sendAckTo(frame.sender, reply, replyLen);
+        EventLog::log(EventLog::RADIO_ACK, frame.sender, millis() - stamp);
+    }
+    else if (replyLen > 0)
+        m_transmit.enqueue(frame.sender, reply, replyLen, false);
+
+    if (toMe && !sensor && !binary)
+        routeCommand(payload, frame.len, frame.sender, toMe);
+}
+
+void PacketWeather::printReceiveQueue()
+{
+    radio.printQueueStatistics();
+}
+
+void PacketWeather::printTransmitQueue()
+{
+    m_transmit.printStatistics();
+}
+
 void PacketWeather::MonitorRSSI(bool b)
 {
     m_monitorRSSI = b;
+    m_rssiSurvey.clearWindow();
+}
+
+void PacketWeather::setAwake(bool awake)
+{
+    if (!radioSetupOK || awake == m_awake)
+        return;
+    m_awake = awake;
+    if (awake)
+        radio.wake();
+    else
+        radio.sleep();
+    EventLog::log(EventLog::RADIO_AWAKE, awake ? 1 : 0);
 }
 
-void PacketWeather::SetThermometerIdMasks(uint32_t indoor, uint32_t outdoor)
+bool PacketWeather::sendTelemetry(const uint8_t *frame, uint8_t len)
 {
-    indoorTemperatureSensorMask = indoor;
-    outdoorTemperatureSensorMask = outdoor;
+    if (!radioSetupOK)
+        return false;
+    return m_transmit.enqueue(GATEWAY_NODEID, frame, len, false) != 0;
 }
 
-void PacketWeather::SetRaingaugeIdMask(uint32_t m)
+bool PacketWeather::configureListen(uint16_t idleMsec, uint16_t rxUsec)
 {
-    raingaugeSensorMask = m;
+    return radio.configureListen(idleMsec, rxUsec);
+}
+
+void PacketWeather::printRssiSurvey()
+{
+    m_rssiSurvey.print();
 }
 
 void PacketWeather::SendRadioMessage(int node, const char *c)
@@ -332,5 +344,16 @@ void PacketWeather::SendRadioMessage(int node, const char *c)
     Serial.print(' ');
     Serial.println(c);
 #endif
-    radio.sendWithRetry(node, c, strlen(c));
+    auto seq = m_transmit.enqueue(node, c, strlen(c), true);
+#if USE_SERIAL > 0
+    if (seq)
+    {
+        Serial.print("Queued seq ");
+        Serial.println(seq);
+    }
+    else
+        Serial.println("Transmit queue full");
+#else
+    (void)seq;
+#endif
 }
@@ -1,30 +1,51 @@
 #pragma once
 #include <RadioConfiguration.h>
 #include <RFM69.h>
+#include "QueuedRFM69.h"
+#include "TransmitQueue.h"
 #include "WWVBclock.h"
+#include "SensorRegistry.h"
+#include "RssiSurvey.h"
+#include "SensorPayload.h"
 
 class PacketWeather {
     public: 
         PacketWeather(int nSS_pin, int int_Pin);
         void setup();
         void loop();
+        bool pending() const { return radioSetupOK && radio.pending(); } // received frames for loop()
         void radioPrintInfo();
         void radioPrintRegs();
         void setNotify(ClockNotification*);
-        void SetThermometerIdMasks(uint32_t indoor, uint32_t outdoor);
-        void SetRaingaugeIdMask(uint32_t);
+        SensorRegistry &sensors() { return m_sensors; }
+        typedef SensorPayload SensorFields;
         void SendRadioMessage(int node, const char *m);
         void MonitorRSSI(bool);
+        void printRssiSurvey();
+        void setAwake(bool); // false puts the RFM69 to sleep
+        bool sendTelemetry(const uint8_t *frame, uint8_t len); // to the gateway, without ACK
+        uint32_t droppedFrames() const { return radio.dropped(); }
+        int16_t noiseFloor() const { return m_rssiSurvey.noiseFloor(); }
+        bool configureListen(uint16_t idleMsec, uint16_t rxUsec); // RFM69 ListenMode. zero idleMsec for continuous receive
+        void printReceiveQueue();
+        void printTransmitQueue();
         bool ProcessCommand(const char* cmd, uint8_t len, uint8_t senderid, bool toMe);
     protected:
-        RFM69 radio;
+        typedef bool (PacketWeather::*SensorHandler_t)(uint8_t senderid, const SensorFields &);
+        static const SensorHandler_t SENSOR_HANDLERS[SensorRegistry::NUM_ROLES];
+        bool isSensor(unsigned senderid) const;
+        bool processSensorPacket(uint8_t senderid, const uint8_t *payload, uint8_t len);
+        bool onThermometer(uint8_t senderid, const SensorFields &);
+        bool onRaingauge(uint8_t senderid, const SensorFields &);
+        void receivedFrame(const QueuedRFM69::Frame &);
+        QueuedRFM69 radio;
+        TransmitQueue m_transmit;
         RadioConfiguration radioConfiguration;
         bool radioSetupOK ;
-        int16_t m_prevRgF;
-        uint32_t indoorTemperatureSensorMask;
-        uint32_t outdoorTemperatureSensorMask;
-        uint32_t raingaugeSensorMask;
+        bool m_awake;
+        SensorRegistry m_sensors;
         bool m_monitorRSSI;
+        RssiSurvey m_rssiSurvey;
         unsigned long m_sleepBegan;
         ClockNotification *m_clock;
 };
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include <RFM69registers.h>
+#include "QueuedRFM69.h"
+#include "SpiBus.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    const unsigned long ACK_CSMA_LIMIT_MSEC = 50;
+
+    uint32_t listenIdleCoef(uint16_t idleMsec)
+    {
+        uint32_t idleCoef = (idleMsec * 1000ul + 2050) / 4100;
+        if (idleMsec != 0 && idleCoef == 0)
+            idleCoef = 1;
+        return idleCoef;
+    }
+
+    uint32_t listenRxCoef(uint16_t rxUsec)
+    {
+        uint32_t rxCoef = (rxUsec + 32u) / 64;
+        return rxCoef == 0 ? 1 : rxCoef;
+    }
+}
+
+QueuedRFM69 *QueuedRFM69::s_self;
+
+QueuedRFM69::QueuedRFM69(uint8_t nssPin, uint8_t irqPin)
+    : RFM69(nssPin, irqPin)
+    , m_irqPin(irqPin)
+    , m_nodeId(0)
+    , m_frames()
+    , m_head(0)
+    , m_tail(0)
+    , m_highWater(0)
+    , m_received(0)
+    , m_dropped(0)
+    , m_oversize(0)
+    , m_ackFrom(0)
+    , m_ackLatched(false)
+    , m_listenIdleCoef(0)
+    , m_listenRxCoef(0)
+    , m_listenWanted(false)
+    , m_listening(false)
+    , m_accountedMsec(0)
+    , m_msecListen(0)
+    , m_msecContinuous(0)
+    , m_framesListen(0)
+    , m_framesContinuous(0)
+{}
+
+void QueuedRFM69::startQueue(uint8_t nodeId)
+{
+    m_nodeId = nodeId;
+    s_self = this;
+    // SPI transactions from loop() mask our interrupt, so the ISR never finds the bus busy
+    SpiBus::usingInterrupt(SpiBus::RADIO, m_irqPin, HIGH);
+    attachInterrupt(digitalPinToInterrupt(m_irqPin), &QueuedRFM69::queueIsr, RISING);
+    receiveBegin();
+}
+
+void QueuedRFM69::queueIsr()
+{
+    s_self->onInterrupt();
+}
+
+void QueuedRFM69::onInterrupt()
+{
+    interruptHandler(); // base class reads the FIFO into DATA, SENDERID, etc.
+    if (PAYLOADLEN == 0)
+        return; // not a received frame
+    if (ACK_RECEIVED)
+    {   // latch it. receiveBegin() below clears the base class copy
+        if (TARGETID == m_nodeId)
+        {
+            m_ackFrom = static_cast<uint8_t>(SENDERID);
+            m_ackLatched = true;
+        }
+    }
+    else
+    {
+        uint8_t count = m_head - m_tail;
+        if (DATALEN > RF69_MAX_DATA_LEN)
+            m_oversize += 1; // the library allows a length byte up to 66. Frame::data doesn't
+        else if (count >= QUEUE_LENGTH)
+            m_dropped += 1;
+        else
+        {
+            auto &f = m_frames[m_head & (QUEUE_LENGTH - 1)];
+            f.sender = static_cast<uint8_t>(SENDERID);
+            f.target = static_cast<uint8_t>(TARGETID);
+            f.rssi = RSSI;
+            f.ackRequested = ACK_REQUESTED != 0;
+            f.len = DATALEN;
+            memcpy(f.data, DATA, f.len);
+            f.data[f.len] = 0;
+            m_head += 1;
+            count += 1;
+            if (count > m_highWater)
+                m_highWater = count;
+            m_received += 1;
+            if (m_listenWanted)
+                m_framesListen += 1;
+            else
+                m_framesContinuous += 1;
+        }
+    }
+    receiveBegin();
+}
+
+void QueuedRFM69::select()
+{
+    RFM69::select();
+    SpiBus::acquired(SpiBus::RADIO);
+}
+
+void QueuedRFM69::unselect()
+{
+    SpiBus::released(SpiBus::RADIO);
+    RFM69::unselect();
+}
+
+bool QueuedRFM69::pop(Frame &f)
+{
+    if (m_head == m_tail)
+        return false;
+    f = m_frames[m_tail & (QUEUE_LENGTH - 1)];
+    m_tail += 1;
+    return true;
+}
+
+void QueuedRFM69::poll()
+{   // restart the receiver if a send stopped it
+    if (receiveDone())
+        receiveBegin();
+}
+
+bool QueuedRFM69::ackReceived(uint8_t from)
+{
+    noInterrupts();
+    bool ret = m_ackLatched && (m_ackFrom == from || from == RF69_BROADCAST_ADDR);
+    if (ret)
+        m_ackLatched = false;
+    interrupts();
+    return ret;
+}
+
+void QueuedRFM69::sendAckTo(uint8_t node, const void *buf, uint8_t len)
+{
+    auto now = millis();
+    while (!canSend() && millis() - now < ACK_CSMA_LIMIT_MSEC)
+        poll();
+    sendFrame(node, buf, len, false, true);
+    receiveBegin();
+}
+
+bool QueuedRFM69::trySend(uint8_t node, const void *buf, uint8_t len, bool requestAck, bool force)
+{
+    poll();
+    if (!canSend() && !force)
+        return false;
+    if (requestAck)
+        m_ackLatched = false; // an ACK to an earlier send doesn't count
+    sendFrame(node, buf, len, requestAck, false);
+    receiveBegin();
+    return true;
+}
+
+void QueuedRFM69::printQueueStatistics()
+{
+#if USE_SERIAL
+    noInterrupts();
+    uint32_t received = m_received;
+    uint32_t dropped = m_dropped;
+    uint32_t oversize = m_oversize;
+    uint8_t highWater = m_highWater;
+    uint8_t queued = m_head - m_tail;
+    interrupts();
+    Serial.print(F("Receive queue: received="));
+    Serial.print(received);
+    Serial.print(F(" dropped="));
+    Serial.print(dropped);
+    Serial.print(F(" oversize="));
+    Serial.print(oversize);
+    Serial.print(F(" high water="));
+    Serial.print(static_cast<int>(highWater));
+    Serial.print('/');
+    Serial.print(static_cast<int>(QUEUE_LENGTH));
+    Serial.print(F(" now queued="));
+    Serial.println(static_cast<int>(queued));
+    if (m_listenIdleCoef == 0 && m_msecListen == 0)
+        return;
+    noInterrupts();
+    uint32_t framesListen = m_framesListen;
+    uint32_t framesContinuous = m_framesContinuous;
+    interrupts();
+    uint32_t rxUsec = m_listenRxCoef * 64ul;
+    uint32_t idleUsec = m_listenIdleCoef * 4100ul;
+    Serial.print(F("ListenMode: "));
+    Serial.print(m_listening ? F("listening") : F("receiving"));
+    Serial.print(F(" duty cycle="));
+    Serial.print(rxUsec + idleUsec ? 100.0 * rxUsec / (rxUsec + idleUsec) : 100.0, 2);
+    Serial.println('%');
+    float listenRate = m_msecListen ? framesListen * 3600000.0 / m_msecListen : 0;
+    float continuousRate = m_msecContinuous ? framesContinuous * 3600000.0 / m_msecContinuous : 0;
+    Serial.print(F("  frames per hour listen="));
+    Serial.print(listenRate, 1);
+    Serial.print(F(" continuous="));
+    Serial.print(continuousRate, 1);
+    if (continuousRate > 0)
+    {
+        Serial.print(F(" capture rate="));
+        Serial.print(100 * listenRate / continuousRate, 1);
+        Serial.print('%');
+    }
+    Serial.println();
+#endif
+}
+
+bool QueuedRFM69::listenCovered(uint16_t idleMsec, uint16_t rxUsec)
+{
+    if (idleMsec == 0)
+        return true; // continuous receive
+    return listenIdleCoef(idleMsec) * 4100 + listenRxCoef(rxUsec) * 64 < SENDER_PREAMBLE_USEC;
+}
+
+bool QueuedRFM69::configureListen(uint16_t idleMsec, uint16_t rxUsec)
+{
+    if (idleMsec > LISTEN_IDLE_MAX_MSEC)
+        idleMsec = 0;
+    if (rxUsec > LISTEN_RX_MAX_USEC)
+        rxUsec = LISTEN_RX_MAX_USEC;
+    bool covered = listenCovered(idleMsec, rxUsec);
+    if (!covered)
+        idleMsec = 0;
+    uint32_t idleCoef = listenIdleCoef(idleMsec);
+    uint32_t rxCoef = listenRxCoef(rxUsec);
+    bool wanted = m_listenWanted;
+    listenMode(false);
+    m_listenIdleCoef = static_cast<uint8_t>(idleCoef);
+    m_listenRxCoef = static_cast<uint8_t>(rxCoef);
+    listenMode(wanted);
+    return covered;
+}
+
+void QueuedRFM69::listenMode(bool wanted)
+{
+    auto now = millis();
+    if (_mode != RF69_MODE_SLEEP)
+    {
+        auto elapsed = now - m_accountedMsec;
+        if (m_listenWanted)
+            m_msecListen += elapsed;
+        else
+            m_msecContinuous += elapsed;
+    }
+    m_accountedMsec = now;
+    wanted = wanted && m_listenIdleCoef != 0;
+    if (wanted == m_listenWanted)
+        return;
+    noInterrupts();
+    m_listenWanted = wanted;
+    if (_mode != RF69_MODE_SLEEP)
+    {   // asleep, wake() starts whichever is wanted
+        if (wanted)
+            enterListen();
+        else
+            receiveBegin();
+    }
+    interrupts();
+}
+
+void QueuedRFM69::receiveBegin()
+{
+    RFM69::receiveBegin();
+    if (m_listenWanted)
+        enterListen();
+}
+
+void QueuedRFM69::setMode(uint8_t mode)
+{   // every mode change made by the base class leaves ListenMode first
+    if (m_listening)
+        stopListen();
+    RFM69::setMode(mode);
+}
+
+void QueuedRFM69::enterListen()
+{
+    if (m_listening)
+        return;
+    RFM69::setMode(RF69_MODE_STANDBY);
+    writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_01); // PayloadReady
+    // stay in receive only on a sync match. Go to standby, ListenMode ended, after PayloadReady
+    writeReg(REG_LISTEN1, RF_LISTEN1_RESOL_IDLE_4100 | RF_LISTEN1_RESOL_RX_64 |
+        RF_LISTEN1_CRITERIA_RSSIANDSYNC | RF_LISTEN1_END_01);
+    writeReg(REG_LISTEN2, m_listenIdleCoef);
+    writeReg(REG_LISTEN3, m_listenRxCoef);
+    writeReg(REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_ON | RF_OPMODE_STANDBY);
+    _mode = RF69_MODE_RX; // so the base interruptHandler reads the FIFO on PayloadReady
+    m_listening = true;
+}
+
+void QueuedRFM69::stopListen()
+{   // ListenAbort must be written together with ListenOn off
+    writeReg(REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_OFF | RF_OPMODE_LISTENABORT | RF_OPMODE_STANDBY);
+    writeReg(REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_OFF | RF_OPMODE_STANDBY);
+    _mode = RF69_MODE_STANDBY;
+    m_listening = false;
+}
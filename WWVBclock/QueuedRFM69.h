@@ -0,0 +1,101 @@
+#pragma once
+#include <RFM69.h>
+#include "WwvbClockDefinitions.h"
+
+/* QueuedRFM69 takes over the RFM69 interrupt. Its ISR reads each received
+** frame out of the radio's FIFO, captures it with its sender, target, RSSI
+** and ACK-request flag in a ring of QUEUE_LENGTH frames, and immediately
+** restarts the receiver. loop() drains the ring with pop(), so a second
+** packet that arrives while loop() is busy is queued instead of lost.
+**
+** An ACK frame addressed to this node is latched by the ISR, which restarts the
+** receiver as for any other frame, and ackReceived() reads the latch. So a
+** poll() or sendAckTo() while waiting for it doesn't throw it away. The base
+** class sendWithRetry/ACKReceived never see it. Use trySend and ackReceived.
+** Call poll() every loop() to restart the receiver after a send.
+** poll() would also wake a sleeping radio, so don't call it between sleep() and wake().
+**
+** Optionally, the radio's hardware ListenMode replaces continuous receive.
+** The RFM69 alternates between idle and short receive windows on its own, and
+** only stays in receive if it matches the sync word within a window. The
+** window must be long enough to hold a sender's preamble plus sync word. A
+** packet is caught only if its preamble is longer than the idle time plus the RX
+** window, so configureListen() refuses an idle time the configured sender
+** preamble, LISTEN_SENDER_PREAMBLE_BYTES, doesn't span. The capture rate is
+** counted for listen mode and continuous receive separately, to check it on the air.
+** Any send, sleep or ACK wait leaves ListenMode, and receiveBegin() goes back to it.
+*/
+class QueuedRFM69 : public RFM69 {
+    public:
+        enum {QUEUE_LENGTH = 8}; // must be power of 2
+        struct Frame {
+            uint8_t sender;
+            uint8_t target;
+            int16_t rssi;
+            bool ackRequested;
+            uint8_t len;
+            uint8_t data[RF69_MAX_DATA_LEN + 1]; // always zero terminated
+        };
+
+        QueuedRFM69(uint8_t nssPin, uint8_t irqPin);
+        void startQueue(uint8_t nodeId); // call after initialize()
+        void poll();
+        void wake() { receiveBegin(); } // after sleep()
+        bool pop(Frame &);
+        bool pending() const { return m_head != m_tail; } // a frame is waiting for pop()
+        void sendAckTo(uint8_t node, const void *buf = "", uint8_t len = 0);
+        // trySend returns false without waiting if the channel is busy, unless force
+        bool trySend(uint8_t node, const void *buf, uint8_t len, bool requestAck, bool force = false);
+        // true once for an ACK from node, or from anyone for RF69_BROADCAST_ADDR, since the last trySend requesting one
+        bool ackReceived(uint8_t from);
+        void printQueueStatistics();
+        uint32_t dropped() const { return m_dropped; }
+
+        // idleMsec of zero turns ListenMode off. Returns false, and turns it off, if the sender preamble is too short
+        bool configureListen(uint16_t idleMsec, uint16_t rxUsec);
+        // call every loop(). ListenMode is used only when configured and wanted
+        void listenMode(bool wanted);
+        bool listening() const { return m_listening; }
+        static const uint16_t LISTEN_IDLE_MAX_MSEC = 1045; // 255 * 4.1 msec
+        static const uint16_t LISTEN_RX_MAX_USEC = 16320; // 255 * 64 usec
+        static const uint32_t BITRATE = 55555; // the RFM69 library default
+        static const uint8_t SYNC_BYTES = 2; // the RFM69 library default
+        static const uint32_t SENDER_PREAMBLE_USEC = (LISTEN_SENDER_PREAMBLE_BYTES * 8 * 1000000ul + BITRATE - 1) / BITRATE;
+        // the RX window holds the sender's preamble and sync word, in 64 usec steps
+        static const uint16_t LISTEN_RX_DEFAULT_USEC =
+            ((LISTEN_SENDER_PREAMBLE_BYTES + SYNC_BYTES) * 8 * 1000000ul / BITRATE + 64) / 64 * 64;
+        // true if the sender preamble spans the idle time, as the radio rounds it, plus the RX window
+        static bool listenCovered(uint16_t idleMsec, uint16_t rxUsec);
+
+    protected:
+        static void queueIsr();
+        void onInterrupt();
+        void receiveBegin() override;
+        void setMode(uint8_t) override;
+        void select() override;
+        void unselect() override;
+        void enterListen();
+        void stopListen();
+        static QueuedRFM69 *s_self;
+        const uint8_t m_irqPin;
+        uint8_t m_nodeId;
+        Frame m_frames[QUEUE_LENGTH];
+        volatile uint8_t m_head; // written only by ISR
+        volatile uint8_t m_tail; // written only by pop
+        volatile uint8_t m_highWater;
+        volatile uint32_t m_received;
+        volatile uint32_t m_dropped;
+        volatile uint32_t m_oversize; // frames dropped for a length longer than RF69_MAX_DATA_LEN
+        volatile uint8_t m_ackFrom;
+        volatile bool m_ackLatched;
+        uint8_t m_listenIdleCoef; // zero when not configured
+        uint8_t m_listenRxCoef;
+        volatile bool m_listenWanted;
+        volatile bool m_listening;
+        unsigned long m_accountedMsec;
+        uint32_t m_msecListen;
+        uint32_t m_msecContinuous;
+        volatile uint32_t m_framesListen;
+        volatile uint32_t m_framesContinuous;
+        static_assert((QUEUE_LENGTH & (QUEUE_LENGTH - 1)) == 0, "QUEUE_LENGTH must be power of 2");
+};
@@ -0,0 +1,113 @@
+#include <Arduino.h>
+#include "ReceptionCoordinator.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    // ORDER MUST MATCH ReceptionCoordinator::Mode_t
+    const char * const MODE_NAMES[ReceptionCoordinator::NUM_MODES] = { "Off", "Duty", "Sleep" };
+}
+
+ReceptionCoordinator::ReceptionCoordinator()
+    : m_mode(MODE_OFF)
+    , m_searchMode(MODE_OFF)
+    , m_listening(false)
+    , m_radioAwake(true)
+    , m_listenBeganMsec(0)
+    , m_prevMsec(0)
+    , m_stats()
+{}
+
+void ReceptionCoordinator::setMode(Mode_t v)
+{
+    if (v >= NUM_MODES)
+        v = MODE_OFF;
+    m_mode = v;
+}
+
+void ReceptionCoordinator::endSearch(unsigned long now, bool success)
+{
+    auto &s = m_stats[m_searchMode];
+    s.listenMsec += now - m_prevMsec;
+    if (success)
+        s.successes += 1;
+    m_listening = false;
+}
+
+void ReceptionCoordinator::loop(bool es100Listening, bool received)
+{
+    auto now = millis();
+    if (received && m_listening)
+        endSearch(now, true);
+    else if (es100Listening && !m_listening)
+    {
+        m_listening = true;
+        m_searchMode = m_mode;
+        m_listenBeganMsec = now;
+        m_prevMsec = now;
+        m_stats[m_searchMode].searches += 1;
+    }
+    else if (!es100Listening && m_listening)
+        endSearch(now, false);
+    else if (m_listening)
+    {
+        m_stats[m_searchMode].listenMsec += now - m_prevMsec;
+        m_prevMsec = now;
+    }
+
+    bool awake = true;
+    if (m_listening)
+    {
+        switch (m_mode)
+        {
+            case MODE_DUTY:
+                awake = (now - m_listenBeganMsec) % DUTY_PERIOD_MSEC >= DUTY_PERIOD_MSEC - DUTY_AWAKE_MSEC;
+                break;
+            case MODE_SLEEP:
+                awake = false;
+                break;
+            default:
+                break;
+        }
+    }
+    m_radioAwake = awake;
+}
+
+uint32_t ReceptionCoordinator::searches() const
+{
+    uint32_t v = 0;
+    for (const auto &s : m_stats)
+        v += s.searches;
+    return v;
+}
+
+uint32_t ReceptionCoordinator::successes() const
+{
+    uint32_t v = 0;
+    for (const auto &s : m_stats)
+        v += s.successes;
+    return v;
+}
+
+void ReceptionCoordinator::printStatistics() const
+{
+#if USE_SERIAL
+    Serial.print(F("ReceptionCoordinator mode: "));
+    Serial.println(MODE_NAMES[m_mode]);
+    for (int i = 0; i < NUM_MODES; i++)
+    {
+        const auto &s = m_stats[i];
+        if (s.searches == 0)
+            continue;
+        Serial.print(F("  "));
+        Serial.print(MODE_NAMES[i]);
+        Serial.print(F(": searches="));
+        Serial.print(s.searches);
+        Serial.print(F(" syncs="));
+        Serial.print(s.successes);
+        Serial.print(F(" listen minutes="));
+        Serial.print(s.listenMsec / 60000ul);
+        Serial.print(F(" syncs per listening hour="));
+        Serial.println(s.listenMsec ? s.successes * 3600000.0 / s.listenMsec : 0.0, 2);
+    }
+#endif
+}
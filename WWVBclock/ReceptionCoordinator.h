@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+
+/* The ReceptionCoordinator quiets the clock's own electronics while the ES100
+** is listening for WWVB. The 60KHz signal is weak and easily swamped by local noise.
+**
+**      MODE_OFF    RFM69 receives continuously. Displays update as usual.
+**      MODE_DUTY   RFM69 sleeps except for DUTY_AWAKE_MSEC of every DUTY_PERIOD_MSEC.
+**      MODE_SLEEP  RFM69 sleeps for the whole time the ES100 listens.
+** In both quiet modes the LCD and LED are rewritten only once a minute, in one burst.
+**
+** Each WWVB search is counted under the mode in use when it began, so
+** PrintWwvbStats can compare the success rate of the modes on an install.
+*/
+class ReceptionCoordinator {
+    public:
+        enum Mode_t : uint8_t {MODE_OFF, MODE_DUTY, MODE_SLEEP, NUM_MODES};
+        static const unsigned long DUTY_PERIOD_MSEC = 60000ul;
+        static const unsigned long DUTY_AWAKE_MSEC = 10000ul;
+
+        ReceptionCoordinator();
+        void setMode(Mode_t);
+        Mode_t mode() const { return m_mode; }
+        // call every loop(). received is true on the loop that the ES100 delivered a time
+        void loop(bool es100Listening, bool received);
+        bool radioAwake() const { return m_radioAwake; }
+        bool displaysQuiet() const { return m_listening && m_mode != MODE_OFF; }
+        void printStatistics() const;
+        // totals over all modes
+        uint32_t searches() const;
+        uint32_t successes() const;
+
+    protected:
+        struct ModeStats {
+            uint32_t searches;
+            uint32_t successes;
+            uint32_t listenMsec;
+        };
+        void endSearch(unsigned long now, bool success);
+        Mode_t m_mode;
+        Mode_t m_searchMode;
+        bool m_listening;
+        bool m_radioAwake;
+        unsigned long m_listenBeganMsec;
+        unsigned long m_prevMsec;
+        ModeStats m_stats[NUM_MODES];
+};
@@ -0,0 +1,163 @@
+#include <Arduino.h>
+#include <TimeLib.h>
+#include <math.h>
+#include "RssiSurvey.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    const unsigned long MINUTE_MSEC = 60000ul;
+}
+
+void RssiSurvey::Welford::clear()
+{
+    n = 0;
+    mean = 0;
+    m2 = 0;
+    min = INT16_MAX;
+    max = INT16_MIN;
+}
+
+void RssiSurvey::Welford::add(int16_t v)
+{
+    n += 1;
+    float delta = v - mean;
+    mean += delta / n;
+    m2 += delta * (v - mean);
+    if (v < min) min = v;
+    if (v > max) max = v;
+}
+
+RssiSurvey::RssiSurvey()
+    : m_histogram()
+    , m_histogramSamples(0)
+    , m_prevSample(0)
+    , m_minuteBegan(0)
+    , m_minuteFloors()
+    , m_nextMinute(0)
+    , m_minutesStored(0)
+    , m_lastFloor(0)
+{
+    m_lifetime.clear();
+    m_window.clear();
+    for (auto &h : m_hours)
+    {
+        h.minFloor = INT16_MAX;
+        h.maxFloor = INT16_MIN;
+        h.sumFloor = 0;
+        h.minutes = 0;
+    }
+}
+
+bool RssiSurvey::due(unsigned long now, bool monitoring) const
+{
+    return now - m_prevSample >= (monitoring ? MONITOR_MSEC : SURVEY_MSEC);
+}
+
+void RssiSurvey::sample(int16_t rssi, unsigned long now)
+{
+    m_prevSample = now;
+    if (m_histogramSamples == 0)
+        m_minuteBegan = now;
+    m_lifetime.add(rssi);
+    m_window.add(rssi);
+    int bin = (rssi - HISTOGRAM_BOTTOM_DB) / BIN_DB;
+    if (bin < 0) bin = 0;
+    if (bin >= HISTOGRAM_BINS) bin = HISTOGRAM_BINS - 1;
+    m_histogram[bin] += 1;
+    m_histogramSamples += 1;
+    if (now - m_minuteBegan >= MINUTE_MSEC)
+        endMinute();
+}
+
+void RssiSurvey::endMinute()
+{
+    uint16_t threshold = (m_histogramSamples * NOISE_PERCENTILE + 99) / 100;
+    uint16_t cumulative = 0;
+    uint8_t bin = 0;
+    for (; bin < HISTOGRAM_BINS - 1; bin++)
+    {
+        cumulative += m_histogram[bin];
+        if (cumulative >= threshold)
+            break;
+    }
+    m_lastFloor = binBottom(bin);
+    m_minuteFloors[m_nextMinute] = static_cast<int8_t>(m_lastFloor);
+    m_nextMinute = (m_nextMinute + 1) % NUM_MINUTES;
+    if (m_minutesStored < NUM_MINUTES)
+        m_minutesStored += 1;
+
+    if (timeStatus() != timeNotSet)
+    {
+        auto &h = m_hours[hour(now())];
+        if (m_lastFloor < h.minFloor) h.minFloor = m_lastFloor;
+        if (m_lastFloor > h.maxFloor) h.maxFloor = m_lastFloor;
+        h.sumFloor += m_lastFloor;
+        h.minutes += 1;
+    }
+
+    memset(m_histogram, 0, sizeof(m_histogram));
+    m_histogramSamples = 0;
+}
+
+void RssiSurvey::print() const
+{
+#if USE_SERIAL
+    Serial.print(F("RSSI samples="));
+    Serial.print(m_lifetime.n);
+    if (m_lifetime.n)
+    {
+        Serial.print(F(" mean="));
+        Serial.print(m_lifetime.mean, 1);
+        Serial.print(F(" stddev="));
+        Serial.print(sqrtf(m_lifetime.variance()), 1);
+        Serial.print(F(" min="));
+        Serial.print(m_lifetime.min);
+        Serial.print(F(" max="));
+        Serial.print(m_lifetime.max);
+    }
+    Serial.println();
+
+    Serial.print(F("This minute ("));
+    Serial.print(m_histogramSamples);
+    Serial.println(F(" samples):"));
+    for (uint8_t bin = 0; bin < HISTOGRAM_BINS; bin++)
+    {
+        if (m_histogram[bin] == 0)
+            continue;
+        Serial.print(F("  "));
+        Serial.print(binBottom(bin));
+        Serial.print(F(" dBm "));
+        Serial.println(m_histogram[bin]);
+    }
+
+    Serial.print(F("Noise floor by minute, oldest first:"));
+    for (uint8_t i = 0; i < m_minutesStored; i++)
+    {
+        if (i % 15 == 0)
+            Serial.print(F("\n "));
+        Serial.print(' ');
+        Serial.print(static_cast<int>(m_minuteFloors[(m_nextMinute + NUM_MINUTES - m_minutesStored + i) % NUM_MINUTES]));
+    }
+    Serial.println();
+
+    Serial.println(F("Noise floor by UTC hour: min/mean/max minutes"));
+    for (uint8_t hr = 0; hr < NUM_HOURS; hr++)
+    {
+        const auto &h = m_hours[hr];
+        if (h.minutes == 0)
+            continue;
+        Serial.print(F("  "));
+        if (hr < 10)
+            Serial.print('0');
+        Serial.print(static_cast<int>(hr));
+        Serial.print(F(": "));
+        Serial.print(h.minFloor);
+        Serial.print('/');
+        Serial.print(h.sumFloor / h.minutes);
+        Serial.print('/');
+        Serial.print(h.maxFloor);
+        Serial.print(' ');
+        Serial.println(h.minutes);
+    }
+#endif
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+
+/* RssiSurvey accumulates the radio's RSSI readings without keeping the samples.
+**
+** Mean and variance are streaming (Welford), both for the lifetime of the survey
+** and for the window printed by MonitorRSSI. Each minute's samples go into a
+** histogram, and the minute's noise floor is taken as its NOISE_PERCENTILE point.
+** That ignores the samples that happened to land on a packet.
+** Minute floors are kept for the last hour, and summarized by hour of day (UTC)
+** so interference that comes and goes on a schedule shows up.
+*/
+class RssiSurvey {
+    public:
+        enum {HISTOGRAM_BINS = 32, BIN_DB = 2, NUM_MINUTES = 60, NUM_HOURS = 24, NOISE_PERCENTILE = 10};
+        static const int16_t HISTOGRAM_BOTTOM_DB = -128; // bottom of the first bin. Last bin is -66 and above
+        static const unsigned long MONITOR_MSEC = 100; // while someone is watching
+        static const unsigned long SURVEY_MSEC = 1000; // otherwise
+
+        struct Welford {
+            uint32_t n;
+            float mean;
+            float m2;
+            int16_t min;
+            int16_t max;
+            void clear();
+            void add(int16_t);
+            float variance() const { return n > 1 ? m2 / (n - 1) : 0; }
+        };
+
+        RssiSurvey();
+        bool due(unsigned long now, bool monitoring) const;
+        void sample(int16_t rssi, unsigned long now);
+        const Welford &window() const { return m_window; }
+        void clearWindow() { m_window.clear(); }
+        int16_t noiseFloor() const { return m_lastFloor; } // zero until the first minute completes
+        void print() const;
+
+    protected:
+        struct HourProfile {
+            int16_t minFloor;
+            int16_t maxFloor;
+            int32_t sumFloor;
+            uint16_t minutes;
+        };
+        void endMinute();
+        int16_t binBottom(uint8_t bin) const { return HISTOGRAM_BOTTOM_DB + bin * BIN_DB; }
+        Welford m_lifetime;
+        Welford m_window;
+        uint16_t m_histogram[HISTOGRAM_BINS]; // current minute
+        uint16_t m_histogramSamples;
+        unsigned long m_prevSample;
+        unsigned long m_minuteBegan;
+        int8_t m_minuteFloors[NUM_MINUTES]; // ring, newest at m_nextMinute-1
+        uint8_t m_nextMinute;
+        uint8_t m_minutesStored;
+        int16_t m_lastFloor;
+        HourProfile m_hours[NUM_HOURS];
+};
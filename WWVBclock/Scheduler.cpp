@@ -0,0 +1,92 @@
+#include <Arduino.h>
+#include "Scheduler.h"
+#include "WwvbClockDefinitions.h"
+
+// defined, so they can be bound to references, as the conditional in the constructor may
+const uint8_t Scheduler::MAX_TASKS;
+const uint8_t Scheduler::MAX_STEPS_PER_LOOP;
+
+Scheduler::Scheduler(const Task *tasks, const char * const *names, uint8_t count, Probe_t probe)
+    : m_tasks(tasks)
+    , m_names(names)
+    , m_count(count < MAX_TASKS ? count : MAX_TASKS)
+    , m_probe(probe)
+    , m_state()
+{}
+
+bool Scheduler::runnable(uint8_t i, unsigned long now, bool finished) const
+{   // once finished, only an event runs the task again in the same loop()
+    const auto &t = m_tasks[i];
+    const auto &s = m_state[i];
+    return s.continuing || s.woken ||
+        (!finished && t.periodMsec != 0 && now - s.lastRunMsec >= t.periodMsec) ||
+        (t.ready && t.ready());
+}
+
+void Scheduler::loop()
+{
+    uint16_t finished = 0; // bit per task that has run to completion this loop()
+    for (uint8_t step = 0; step < MAX_STEPS_PER_LOOP; step++)
+    {
+        auto now = millis();
+        int8_t next = -1;
+        for (uint8_t i = 0; i < m_count; i++)
+            if ((next < 0 || m_tasks[i].priority < m_tasks[next].priority) && runnable(i, now, finished & (1u << i)))
+                next = static_cast<int8_t>(i);
+        if (next < 0)
+            break;
+        auto &s = m_state[next];
+        if (!s.continuing)
+        {
+            s.runs += 1;
+            s.lastRunMsec = now;
+        }
+        s.woken = false;
+        if (m_probe)
+            m_probe(static_cast<uint8_t>(next));
+        auto began = micros();
+        s.continuing = m_tasks[next].run();
+        uint32_t usec = micros() - began;
+        s.steps += 1;
+        if (usec > s.maxUsec)
+            s.maxUsec = usec;
+        if (usec > m_tasks[next].budgetUsec)
+            s.overruns += 1;
+        if (!s.continuing)
+            finished |= 1u << next;
+    }
+}
+
+void Scheduler::wake(uint8_t task)
+{
+    if (task < m_count)
+        m_state[task].woken = true;
+}
+
+void Scheduler::print() const
+{
+#if USE_SERIAL
+    Serial.println(F("Task priority period budget runs steps overruns max usec"));
+    for (uint8_t i = 0; i < m_count; i++)
+    {
+        const auto &t = m_tasks[i];
+        const auto &s = m_state[i];
+        Serial.print(F("  "));
+        Serial.print(m_names[i]);
+        Serial.print(' ');
+        Serial.print(t.priority);
+        Serial.print(' ');
+        Serial.print(t.periodMsec);
+        Serial.print(' ');
+        Serial.print(t.budgetUsec);
+        Serial.print(' ');
+        Serial.print(s.runs);
+        Serial.print(' ');
+        Serial.print(s.steps);
+        Serial.print(' ');
+        Serial.print(s.overruns);
+        Serial.print(' ');
+        Serial.println(s.maxUsec);
+    }
+#endif
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+
+/* Scheduler runs the sketch's subsystems as cooperative tasks, instead of
+** loop() calling every one of them on every pass.
+**
+** A task is a function that does one step of work and returns. It becomes
+** runnable when its period has elapsed, when its ready() function says an event
+** is waiting, or when wake() is called. A step that returns true has more to do:
+** it yields, and the task continues on a later step, but only after any
+** higher priority task that became runnable in the meantime. That is how a
+** received radio frame gets handled between the two halves of an LCD redraw.
+**
+** Each loop() runs runnable tasks, highest priority first, until none are left.
+** A task that has finished its work runs again in the same loop() only for an event.
+** Steps that take longer than the task's budget are counted as overruns.
+*/
+class Scheduler {
+    public:
+        typedef bool (*Run_t)(); // one step. true to yield with more to do
+        typedef bool (*Ready_t)(); // true if an event is waiting. Must be cheap
+        typedef void (*Probe_t)(uint8_t task); // called before each step
+
+        struct Task {
+            uint8_t priority; // 0 is highest
+            uint16_t periodMsec; // zero to run only on ready() or wake()
+            uint16_t budgetUsec; // per step
+            Run_t run;
+            Ready_t ready; // nullptr for none
+        };
+        static const uint8_t MAX_TASKS = 16;
+        static const uint8_t MAX_STEPS_PER_LOOP = 32;
+
+        // tasks and names have count entries. wake() and the statistics are indexed the same way
+        Scheduler(const Task *tasks, const char * const *names, uint8_t count, Probe_t probe = nullptr);
+        void loop();
+        void wake(uint8_t task);
+        void print() const;
+
+    protected:
+        struct State {
+            bool continuing;
+            volatile bool woken;
+            unsigned long lastRunMsec;
+            uint32_t runs;
+            uint32_t steps;
+            uint32_t overruns;
+            uint32_t maxUsec;
+        };
+        bool runnable(uint8_t, unsigned long now, bool finished) const;
+        const Task * const m_tasks;
+        const char * const * const m_names;
+        const uint8_t m_count;
+        const Probe_t m_probe;
+        State m_state[MAX_TASKS];
+};
@@ -0,0 +1,278 @@
+#include <Arduino.h>
+#include "SensorHistory.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    const unsigned long STALE_MSEC = 5ul * SensorHistory::SAMPLE_MSEC;
+    const int32_t TREND_THRESHOLD = 30; // hundredths of a degree, or mm of rain
+    const uint8_t MINUTES_PER_BUCKET = 60;
+
+    int16_t clamp16(int32_t v)
+    {
+        if (v > INT16_MAX) return INT16_MAX;
+        if (v < -INT16_MAX) return -INT16_MAX;
+        return static_cast<int16_t>(v);
+    }
+}
+
+SensorHistory::SensorHistory()
+    : m_channels()
+    , m_lastSampleMsec(0)
+{}
+
+uint32_t SensorHistory::zigzag(int32_t v)
+{
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+int32_t SensorHistory::unzigzag(uint32_t v)
+{
+    return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+int8_t SensorHistory::channelOf(uint8_t nodeId) const
+{
+    if (nodeId == 0)
+        return -1;
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++)
+        if (m_channels[i].nodeId == nodeId)
+            return i;
+    return -1;
+}
+
+void SensorHistory::assignChannels(const SensorRegistry &sensors)
+{
+    for (auto &ch : m_channels)
+        if (ch.nodeId != 0 && sensors.role(ch.nodeId) == SensorRegistry::ROLE_NONE)
+            ch.nodeId = 0;
+    for (unsigned id = 1; id < SensorRegistry::NUM_NODE_IDS; id++)
+    {
+        if (sensors.role(id) == SensorRegistry::ROLE_NONE || channelOf(id) >= 0)
+            continue;
+        for (auto &ch : m_channels)
+        {
+            if (ch.nodeId == 0)
+            {
+                memset(&ch, 0, sizeof(ch));
+                ch.nodeId = static_cast<uint8_t>(id);
+                break;
+            }
+        }
+    }
+}
+
+void SensorHistory::loop(const SensorRegistry &sensors)
+{
+    auto now = millis();
+    if (now - m_lastSampleMsec < SAMPLE_MSEC)
+        return;
+    m_lastSampleMsec = now;
+    assignChannels(sensors);
+    for (auto &ch : m_channels)
+    {
+        if (ch.nodeId == 0)
+            continue;
+        const auto &e = sensors.entry(ch.nodeId);
+        bool have = e.lastSeenMsec != 0;
+        // rain gauge values are cumulative, so they stay good between reports
+        if (sensors.role(ch.nodeId) != SensorRegistry::ROLE_RAINGAUGE)
+            have = have && (now - e.lastSeenMsec < STALE_MSEC);
+        record(ch, have, e.lastValue);
+    }
+}
+
+void SensorHistory::record(Channel &ch, bool have, int32_t value)
+{
+    uint8_t code[3];
+    uint8_t len = 1;
+    auto prev = ch.prev;
+    auto v = clamp16(value);
+    if (!have)
+        code[0] = GAP_CODE;
+    else
+    {
+        auto z = zigzag(static_cast<int32_t>(v) - prev);
+        if (z <= MAX_ONE_BYTE_CODE)
+            code[0] = static_cast<uint8_t>(z);
+        else
+        {
+            code[0] = ESCAPE_CODE;
+            code[1] = static_cast<uint8_t>(v);
+            code[2] = static_cast<uint8_t>(v >> 8);
+            len = 3;
+        }
+        ch.prev = v;
+    }
+    append(ch, prev, code, len);
+
+    auto &bucket = ch.hours[(ch.minutes / MINUTES_PER_BUCKET) % NUM_HOUR_BUCKETS];
+    if (ch.minutes % MINUTES_PER_BUCKET == 0)
+        bucket = HourBucket();
+    if (have)
+    {
+        if (bucket.samples == 0 || v < bucket.min)
+            bucket.min = v;
+        if (bucket.samples == 0 || v > bucket.max)
+            bucket.max = v;
+        bucket.sum += v;
+        bucket.samples += 1;
+    }
+    ch.minutes += 1;
+}
+
+void SensorHistory::append(Channel &ch, int16_t prev, const uint8_t *code, uint8_t len)
+{
+    Block *b = &ch.blocks[ch.newestBlock];
+    if (ch.numBlocks == 0 || b->used + len > BLOCK_DATA_BYTES)
+    {   // start a new block, discarding the oldest if all are in use
+        if (ch.numBlocks != 0)
+            ch.newestBlock = (ch.newestBlock + 1) % BLOCKS_PER_CHANNEL;
+        if (ch.numBlocks < BLOCKS_PER_CHANNEL)
+            ch.numBlocks += 1;
+        b = &ch.blocks[ch.newestBlock];
+        b->base = prev;
+        b->count = 0;
+        b->used = 0;
+    }
+    memcpy(b->data + b->used, code, len);
+    b->used += len;
+    b->count += 1;
+}
+
+bool SensorHistory::stats(uint8_t channel, uint8_t hours, Stats &s) const
+{
+    if (channel >= MAX_CHANNELS)
+        return false;
+    const auto &ch = m_channels[channel];
+    if (ch.nodeId == 0 || ch.minutes == 0)
+        return false;
+    if (hours >= NUM_HOUR_BUCKETS)
+        hours = NUM_HOUR_BUCKETS - 1;
+    int32_t current = (ch.minutes - 1) / MINUTES_PER_BUCKET;
+    int32_t sum = 0;
+    s = Stats();
+    for (int32_t b = current; b >= 0 && b >= current - hours; b--)
+    {
+        const auto &bucket = ch.hours[b % NUM_HOUR_BUCKETS];
+        if (bucket.samples == 0)
+            continue;
+        if (s.samples == 0 || bucket.min < s.min)
+            s.min = bucket.min;
+        if (s.samples == 0 || bucket.max > s.max)
+            s.max = bucket.max;
+        sum += bucket.sum;
+        s.samples += bucket.samples;
+    }
+    if (s.samples == 0)
+        return false;
+    s.mean = sum / s.samples;
+    return true;
+}
+
+int8_t SensorHistory::trend(uint8_t channel) const
+{
+    if (channel >= MAX_CHANNELS)
+        return 0;
+    const auto &ch = m_channels[channel];
+    int32_t lastComplete = static_cast<int32_t>(ch.minutes / MINUTES_PER_BUCKET) - 1;
+    if (ch.nodeId == 0 || lastComplete < 1)
+        return 0;
+    const auto &recent = ch.hours[lastComplete % NUM_HOUR_BUCKETS];
+    const auto &before = ch.hours[(lastComplete - 1) % NUM_HOUR_BUCKETS];
+    if (recent.samples == 0 || before.samples == 0)
+        return 0;
+    auto diff = recent.sum / recent.samples - before.sum / before.samples;
+    if (diff > TREND_THRESHOLD)
+        return 1;
+    if (diff < -TREND_THRESHOLD)
+        return -1;
+    return 0;
+}
+
+void SensorHistory::printStats(uint8_t channel, uint8_t hours) const
+{
+#if USE_SERIAL
+    Stats s;
+    Serial.print(F("  last "));
+    Serial.print(static_cast<int>(hours) + 1);
+    Serial.print(F(" hr:"));
+    if (stats(channel, hours, s))
+    {
+        Serial.print(F(" min="));
+        Serial.print(s.min);
+        Serial.print(F(" max="));
+        Serial.print(s.max);
+        Serial.print(F(" mean="));
+        Serial.print(s.mean);
+        Serial.print(F(" samples="));
+        Serial.println(s.samples);
+    }
+    else
+        Serial.println(F(" no data"));
+#endif
+}
+
+void SensorHistory::dump(uint8_t nodeId, uint16_t minutes) const
+{
+#if USE_SERIAL
+    auto channel = channelOf(nodeId);
+    if (channel < 0)
+    {
+        Serial.println(F("No history for that sensor"));
+        return;
+    }
+    const auto &ch = m_channels[channel];
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < ch.numBlocks; i++)
+        total += ch.blocks[i].count;
+    if (minutes > total)
+        minutes = total;
+    uint32_t skip = total - minutes;
+    Serial.print(F("History of sensor "));
+    Serial.print(static_cast<int>(nodeId));
+    Serial.print(F(". minutes stored="));
+    Serial.print(total);
+    Serial.print(F(" ("));
+    Serial.print(total / 60.0f, 1);
+    Serial.println(F(" hours)"));
+    uint32_t ago = total;
+    uint8_t idx = (ch.newestBlock + BLOCKS_PER_CHANNEL + 1 - ch.numBlocks) % BLOCKS_PER_CHANNEL;
+    for (uint8_t i = 0; i < ch.numBlocks; i++, idx = (idx + 1) % BLOCKS_PER_CHANNEL)
+    {
+        const auto &b = ch.blocks[idx];
+        int32_t v = b.base;
+        for (uint8_t k = 0, j = 0; k < b.count; k++)
+        {
+            bool have = true;
+            auto c = b.data[j++];
+            if (c == GAP_CODE)
+                have = false;
+            else if (c == ESCAPE_CODE)
+            {
+                v = static_cast<int16_t>(b.data[j] | (b.data[j+1] << 8));
+                j += 2;
+            }
+            else
+                v += unzigzag(c);
+            ago -= 1;
+            if (skip > 0)
+            {
+                skip -= 1;
+                continue;
+            }
+            Serial.print('-');
+            Serial.print(ago);
+            Serial.print(' ');
+            if (have)
+                Serial.println(v);
+            else
+                Serial.println(F("none"));
+        }
+    }
+    printStats(channel, 0);
+    printStats(channel, 5);
+    printStats(channel, 23);
+    Serial.print(F("  trend: "));
+    Serial.println(static_cast<int>(trend(channel)));
+#endif
+}
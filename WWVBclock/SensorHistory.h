@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include "SensorRegistry.h"
+
+/* SensorHistory keeps one sample per minute for up to MAX_CHANNELS registered
+** sensors. All storage is in this object, about 8 KB. No heap.
+**
+** Each channel is a ring of fixed size blocks. A block has a 4 byte header
+** (the value preceding its first sample, sample count, bytes used) followed by
+** samples encoded as the zigzag of their difference from the previous sample.
+** A minute-to-minute change of a thermometer fits in one byte. Bigger changes
+** cost three. When the newest block fills, the oldest block is discarded.
+** So how far back a channel goes depends on its data: 25 full hours while its
+** changes fit in one byte, down to about 8.7 hours if every sample costs three
+** (20 per block). dump() reports the span actually stored.
+**
+** For window queries each channel also keeps a min/max/sum per hour. A query
+** combines at most NUM_HOUR_BUCKETS of those, no matter how many samples are stored.
+*/
+class SensorHistory {
+    public:
+        enum {MAX_CHANNELS = 4,
+            BLOCK_BYTES = 64,
+            // 60 one-byte samples per block. The newest block may have just started,
+            // so 26 blocks hold 25 full hours of one-byte samples, not 26
+            BLOCKS_PER_CHANNEL = 26,
+            NUM_HOUR_BUCKETS = 27};
+        static const unsigned long SAMPLE_MSEC = 60000ul;
+
+        struct Stats {
+            int16_t min;
+            int16_t max;
+            int32_t mean;
+            uint16_t samples;
+        };
+
+        SensorHistory();
+        void loop(const SensorRegistry &);
+        int8_t channelOf(uint8_t nodeId) const;
+        // hours covers the current hour plus that many full hours before it
+        bool stats(uint8_t channel, uint8_t hours, Stats &) const;
+        // +1 rising, -1 falling, 0 steady, comparing the last two complete hours
+        int8_t trend(uint8_t channel) const;
+        void dump(uint8_t nodeId, uint16_t minutes) const;
+
+    protected:
+        enum {GAP_CODE = 0xFD, ESCAPE_CODE = 0xFE, MAX_ONE_BYTE_CODE = 0xFC,
+            BLOCK_DATA_BYTES = BLOCK_BYTES - 4};
+        struct Block {
+            int16_t base; // value preceding the first sample in this block
+            uint8_t count;
+            uint8_t used;
+            uint8_t data[BLOCK_DATA_BYTES];
+        };
+        struct HourBucket {
+            int16_t min;
+            int16_t max;
+            int32_t sum;
+            uint8_t samples;
+        };
+        struct Channel {
+            uint8_t nodeId; // zero for unused channel
+            uint8_t newestBlock;
+            uint8_t numBlocks;
+            int16_t prev; // most recent sample value
+            uint32_t minutes; // samples recorded, including gaps
+            Block blocks[BLOCKS_PER_CHANNEL];
+            HourBucket hours[NUM_HOUR_BUCKETS];
+        };
+        static_assert(sizeof(Block) == BLOCK_BYTES, "Block must pack to BLOCK_BYTES");
+
+        void assignChannels(const SensorRegistry &);
+        void record(Channel &, bool have, int32_t value);
+        void append(Channel &, int16_t prev, const uint8_t *code, uint8_t len);
+        void printStats(uint8_t channel, uint8_t hours) const;
+        static uint32_t zigzag(int32_t);
+        static int32_t unzigzag(uint32_t);
+        Channel m_channels[MAX_CHANNELS];
+        unsigned long m_lastSampleMsec;
+};
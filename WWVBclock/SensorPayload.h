@@ -0,0 +1,103 @@
+#pragma once
+#include <stdint.h>
+#include <ctype.h>
+
+/* Weather sensor payloads are ASCII key:value pairs. Examples:
+**      C:49433, B:244, T:+20.37
+**      C:1769, B:198, T:+20.58 R:45.46
+**      C:112, B:201, F: -1234 RG: 1
+** parse() makes a single pass over the packet, in place in
+** the radio's buffer, and converts every value to fixed point hundredths.
+** No copy, no atof.
+**
+** Digits past the hundredths are ignored. A value with more than
+** MAX_INTEGER_DIGITS digits before the decimal point would overflow x100,
+** so that field is left out of present.
+**
+** No Arduino dependencies. The SensorPayloadFuzz host program shares this file.
+*/
+struct SensorPayload {
+    enum Key_t {C, B, T, R, F, RG, NUM_KEYS};
+    static const uint8_t MAX_INTEGER_DIGITS = 7; // 9,999,999.99 fits x100 in int32_t
+
+    uint8_t present; // bit per Key_t
+    int32_t x100[NUM_KEYS];
+    bool has(Key_t k) const { return 0 != (present & (1 << k)); }
+    int32_t integer(Key_t k) const { return x100[k] / 100; }
+
+    static int8_t key(const uint8_t *key, uint8_t len)
+    {
+        if (len == 1)
+        {
+            switch (key[0])
+            {
+                case 'C': return C;
+                case 'B': return B;
+                case 'T': return T;
+                case 'R': return R;
+                case 'F': return F;
+            }
+        }
+        else if (len == 2 && key[0] == 'R' && key[1] == 'G')
+            return RG;
+        return -1;
+    }
+
+    void parse(const uint8_t *p, uint8_t len)
+    {
+        present = 0;
+        const uint8_t *end = p + len;
+        while (p < end && *p)
+        {
+            if (!isupper(*p))
+            {
+                p += 1;
+                continue;
+            }
+            const uint8_t *k = p;
+            while (p < end && isupper(*p))
+                p += 1;
+            if (p >= end || *p != ':')
+                continue;
+            auto which = key(k, static_cast<uint8_t>(p - k));
+            p += 1;
+            while (p < end && *p == ' ')
+                p += 1;
+            bool neg = false;
+            if (p < end && (*p == '-' || *p == '+'))
+                neg = *p++ == '-';
+            int32_t v = 0;
+            int8_t decimals = -1; // count of digits seen after the decimal point
+            uint8_t integerDigits = 0; // not counting leading zeros
+            bool digits = false;
+            bool overflow = false;
+            for (; p < end; p++)
+            {
+                if (*p >= '0' && *p <= '9')
+                {
+                    digits = true;
+                    if (decimals < 0 && (v != 0 || *p != '0') && ++integerDigits > MAX_INTEGER_DIGITS)
+                        overflow = true; // keep going to the end of the field
+                    if (!overflow && decimals < 2)
+                    {
+                        v = v * 10 + (*p - '0');
+                        if (decimals >= 0)
+                            decimals += 1;
+                    }
+                }
+                else if (*p == '.' && decimals < 0)
+                    decimals = 0;
+                else
+                    break;
+            }
+            if (!digits || overflow || which < 0)
+                continue;
+            if (decimals < 0)
+                decimals = 0;
+            for (; decimals < 2; decimals++)
+                v *= 10;
+            x100[which] = neg ? -v : v;
+            present |= 1 << which;
+        }
+    }
+};
@@ -0,0 +1,147 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "SensorRegistry.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    const uint8_t REGISTRY_SIGNATURE = 0x5E;
+    const uint8_t REGISTRY_VERSION = 1;
+    const uint8_t NUM_MASK_IDS = 32;
+    // ORDER MUST MATCH SensorRegistry::Role_t
+    const char * const ROLE_NAMES[SensorRegistry::NUM_ROLES] = { "none", "Indoor", "Outdoor", "Raingauge" };
+}
+
+SensorRegistry::SensorRegistry()
+    : m_eepromAddress(0)
+    , m_persisted()
+    , m_entries()
+{}
+
+bool SensorRegistry::setup(uint16_t eepromAddress)
+{
+    m_eepromAddress = eepromAddress;
+    if (EEPROM.read(m_eepromAddress) != REGISTRY_SIGNATURE ||
+        EEPROM.read(m_eepromAddress + 1) != REGISTRY_VERSION)
+    {
+        clearAll();
+        return false;
+    }
+    EEPROM.get(m_eepromAddress + 2, m_persisted);
+    for (auto &p : m_persisted)
+        if (p.role >= NUM_ROLES)
+            p.role = ROLE_NONE;
+    return true;
+}
+
+void SensorRegistry::clearAll()
+{
+    memset(m_persisted, 0, sizeof(m_persisted));
+    EEPROM.put(m_eepromAddress + 2, m_persisted);
+    EEPROM.write(m_eepromAddress, REGISTRY_SIGNATURE);
+    EEPROM.write(m_eepromAddress + 1, REGISTRY_VERSION);
+}
+
+void SensorRegistry::persist(uint8_t id)
+{
+    EEPROM.put(m_eepromAddress + 2 + id * sizeof(Persisted), m_persisted[id]);
+}
+
+bool SensorRegistry::setRole(uint8_t id, Role_t r, int8_t calibration)
+{
+    if (r >= NUM_ROLES)
+        return false;
+    auto &p = m_persisted[id];
+    if (p.role == r && p.calibration == calibration)
+        return true;
+    p.role = r;
+    p.calibration = calibration;
+    m_entries[id] = Entry();
+    persist(id);
+    return true;
+}
+
+void SensorRegistry::setFromMask(Role_t r, uint32_t mask)
+{
+    for (uint8_t id = 1; id <= NUM_MASK_IDS; id++)
+    {
+        bool inMask = 0 != (mask & (1ul << (id - 1)));
+        if (inMask)
+            setRole(id, r, m_persisted[id].calibration);
+        else if (role(id) == r)
+            setRole(id, ROLE_NONE);
+    }
+}
+
+uint32_t SensorRegistry::mask(Role_t r) const
+{
+    uint32_t ret = 0;
+    for (uint8_t id = 1; id <= NUM_MASK_IDS; id++)
+        if (role(id) == r)
+            ret |= 1ul << (id - 1);
+    return ret;
+}
+
+int32_t SensorRegistry::calibrated(uint8_t id, int32_t value) const
+{
+    switch (role(id))
+    {
+        case ROLE_INDOOR_TEMP:
+        case ROLE_OUTDOOR_TEMP:
+            return value + 10 * m_persisted[id].calibration;
+        default:
+            return value;
+    }
+}
+
+void SensorRegistry::seen(uint8_t id, int32_t value)
+{
+    auto &e = m_entries[id];
+    e.lastValue = value;
+    e.lastSeenMsec = millis();
+}
+
+const char *SensorRegistry::roleName(Role_t r)
+{
+    return r < NUM_ROLES ? ROLE_NAMES[r] : "?";
+}
+
+bool SensorRegistry::roleFromChar(char c, Role_t &r)
+{
+    switch (toupper(c))
+    {
+        case 'N': case '0': r = ROLE_NONE; return true;
+        case 'I': case '1': r = ROLE_INDOOR_TEMP; return true;
+        case 'O': case '2': r = ROLE_OUTDOOR_TEMP; return true;
+        case 'R': case '3': r = ROLE_RAINGAUGE; return true;
+    }
+    return false;
+}
+
+void SensorRegistry::print() const
+{
+#if USE_SERIAL
+    auto now = millis();
+    for (unsigned id = 0; id < NUM_NODE_IDS; id++)
+    {
+        auto r = role(id);
+        if (r == ROLE_NONE)
+            continue;
+        const auto &e = m_entries[id];
+        Serial.print(F("Sensor "));
+        Serial.print(id);
+        Serial.print(' ');
+        Serial.print(ROLE_NAMES[r]);
+        Serial.print(F(" cal="));
+        Serial.print(static_cast<int>(m_persisted[id].calibration));
+        if (e.lastSeenMsec != 0)
+        {
+            Serial.print(F(" value="));
+            Serial.print(e.lastValue);
+            Serial.print(F(" seconds ago="));
+            Serial.println((now - e.lastSeenMsec) / 1000);
+        }
+        else
+            Serial.println(F(" not heard"));
+    }
+#endif
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+
+/* SensorRegistry has an entry for every possible RFM69 node ID.
+** The entry's role says what kind of weather sensor that node is, if any,
+** so classifying a received packet is a single array index.
+**
+** The role and calibration of each node are persisted in EEPROM, two bytes per node,
+** starting at the address passed to setup().
+** The last value and last-seen time are RAM only.
+*/
+class SensorRegistry {
+    public:
+        enum Role_t : uint8_t {ROLE_NONE, ROLE_INDOOR_TEMP, ROLE_OUTDOOR_TEMP, ROLE_RAINGAUGE, NUM_ROLES};
+        enum {NUM_NODE_IDS = 256,
+            EEPROM_BYTES_USED = 2 + NUM_NODE_IDS * 2}; // signature, version, table
+
+        struct Entry {
+            int32_t lastValue; // temperature in hundredths C. rain gauge: total mm since power up
+            int16_t aux; // rain gauge: previous magnetometer reading
+            unsigned long lastSeenMsec;
+        };
+
+        SensorRegistry();
+        // setup returns false if the EEPROM had no registry. Caller may then setFromMask()
+        bool setup(uint16_t eepromAddress);
+        void clearAll();
+
+        Role_t role(uint8_t id) const { return static_cast<Role_t>(m_persisted[id].role); }
+        int8_t calibration(uint8_t id) const { return m_persisted[id].calibration; }
+        Entry &entry(uint8_t id) { return m_entries[id]; }
+        const Entry &entry(uint8_t id) const { return m_entries[id]; }
+
+        bool setRole(uint8_t id, Role_t, int8_t calibration = 0);
+
+        // Masks cover node IDs 1 through 32, as configured by earlier versions of this sketch
+        void setFromMask(Role_t, uint32_t mask);
+        uint32_t mask(Role_t) const;
+
+        // apply the calibration for this id, which is an offset in tenths of a degree C for thermometers.
+        int32_t calibrated(uint8_t id, int32_t value) const;
+        void seen(uint8_t id, int32_t value);
+        void print() const;
+        static const char *roleName(Role_t);
+        static bool roleFromChar(char, Role_t &);
+
+    protected:
+        void persist(uint8_t id);
+        struct Persisted {
+            uint8_t role;
+            int8_t calibration;
+        };
+        uint16_t m_eepromAddress;
+        Persisted m_persisted[NUM_NODE_IDS];
+        Entry m_entries[NUM_NODE_IDS];
+};
@@ -0,0 +1,174 @@
+#pragma once
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "Crc16.h"
+#include "WwvbClockDefinitions.h"
+
+/* SettingsStore keeps a settings struct in RAM and writes it to EEPROM as one image:
+**      magic, sequence, version, length, the struct, CRC-16 of all but the magic
+** There are two slots, and commit() writes the one not holding the newest image,
+** with the next sequence number. A power failure partway through a commit()
+** leaves that slot failing its CRC, and load() takes the other, older image.
+** load() takes the newest slot whose CRC checks.
+**
+** Changes are written back once they have settled for SETTLE_MSEC, or at
+** once by commit(). An image identical to the one last written is not written again.
+**
+** Teensy 4 EEPROM is emulated in flash, where a write can stall for milliseconds,
+** so the counters show how many changes it took to cause a commit.
+**
+** Add members only at the end of the struct. An image from an older version
+** then loads its shorter prefix, and the new members read as 0xFF, the same
+** as never programmed EEPROM.
+*/
+template <typename T>
+class SettingsStore {
+    public:
+        static const uint32_t MAGIC = 0x57574353ul; // "WWCS"
+        static const uint8_t VERSION = 2;
+        struct Header {
+            uint32_t magic;
+            uint16_t sequence;
+            uint8_t version;
+            uint8_t length; // of the struct
+        };
+        static const uint16_t SLOT_BYTES = sizeof(Header) + sizeof(T) + sizeof(uint16_t);
+        static const unsigned long SETTLE_MSEC = 5000;
+        static_assert(sizeof(Header) == 8, "SettingsStore::Header has padding");
+        static_assert(sizeof(T) <= 0xFF, "settings image length must fit its length byte");
+
+        enum Load_t {LOADED, NO_IMAGE, BAD_IMAGE}; // BAD_IMAGE if a slot has the magic but none checks
+
+        SettingsStore(T &image)
+            : m_image(image)
+            , m_address()
+            , m_slot(1) // so the first commit() without a load goes to slot 0
+            , m_sequence(0)
+            , m_dirty(false)
+            , m_saved(false)
+            , m_changedMsec(0)
+            , m_savedCrc(0)
+            , m_changes(0)
+            , m_commits(0)
+            , m_unchanged(0)
+        {}
+
+        Load_t load(uint16_t address0, uint16_t address1)
+        {
+            m_address[0] = address0;
+            m_address[1] = address1;
+            bool magic = false;
+            int8_t newest = -1;
+            Header newestHeader = {};
+            for (uint8_t slot = 0; slot < 2; slot++)
+            {
+                Header h;
+                EEPROM.get(m_address[slot], h);
+                if (h.magic != MAGIC)
+                    continue;
+                magic = true;
+                if (!readSlot(slot, h))
+                    continue;
+                if (newest < 0 || static_cast<int16_t>(h.sequence - newestHeader.sequence) > 0)
+                {
+                    newest = static_cast<int8_t>(slot);
+                    newestHeader = h;
+                }
+            }
+            if (newest < 0)
+                return magic ? BAD_IMAGE : NO_IMAGE;
+            if (newest == 0)
+                readSlot(0, newestHeader); // slot 1 was read last
+            memset(reinterpret_cast<uint8_t *>(&m_image) + newestHeader.length, 0xFF, sizeof(T) - newestHeader.length);
+            m_slot = static_cast<uint8_t>(newest);
+            m_sequence = newestHeader.sequence;
+            m_savedCrc = crc16(&m_image, sizeof(T));
+            m_saved = newestHeader.length == sizeof(T);
+            return LOADED;
+        }
+
+        // call after changing the image
+        void changed()
+        {
+            m_dirty = true;
+            m_changedMsec = millis();
+            m_changes += 1;
+        }
+
+        void loop()
+        {
+            if (m_dirty && millis() - m_changedMsec >= SETTLE_MSEC)
+                commit();
+        }
+
+        void commit()
+        {
+            if (!m_dirty)
+                return;
+            m_dirty = false;
+            auto imageCrc = crc16(&m_image, sizeof(T));
+            if (m_saved && imageCrc == m_savedCrc)
+            {
+                m_unchanged += 1;
+                return;
+            }
+            m_slot ^= 1;
+            m_sequence += 1;
+            Header h = { MAGIC, m_sequence, VERSION, static_cast<uint8_t>(sizeof(T)) };
+            auto address = m_address[m_slot];
+            EEPROM.put(address, h);
+            EEPROM.put(address + sizeof(Header), m_image);
+            EEPROM.put(address + sizeof(Header) + sizeof(T), slotCrc(h)); // last, so a partial write fails the check
+            m_savedCrc = imageCrc;
+            m_saved = true;
+            m_commits += 1;
+        }
+
+        void print() const
+        {
+#if USE_SERIAL
+            Serial.print(F("Settings slot="));
+            Serial.print(static_cast<int>(m_slot));
+            Serial.print(F(" sequence="));
+            Serial.print(m_sequence);
+            Serial.print(F(" changes="));
+            Serial.print(m_changes);
+            Serial.print(F(" EEPROM commits="));
+            Serial.print(m_commits);
+            Serial.print(F(" unchanged="));
+            Serial.print(m_unchanged);
+            if (m_dirty)
+                Serial.print(F(" pending"));
+            Serial.println();
+#endif
+        }
+
+    protected:
+        uint16_t slotCrc(const Header &h) const
+        {
+            return crc16(&m_image, h.length, crc16(&h.sequence, sizeof(Header) - sizeof(h.magic)));
+        }
+        bool readSlot(uint8_t slot, const Header &h)
+        {   // reads the struct into m_image. true if its CRC checks
+            if (h.version != VERSION || h.length == 0 || h.length > sizeof(T))
+                return false;
+            auto address = m_address[slot] + sizeof(Header);
+            auto p = reinterpret_cast<uint8_t *>(&m_image);
+            for (uint8_t i = 0; i < h.length; i++)
+                p[i] = EEPROM.read(address + i);
+            uint16_t crc;
+            EEPROM.get(address + h.length, crc);
+            return crc == slotCrc(h);
+        }
+        T &m_image;
+        uint16_t m_address[2];
+        uint8_t m_slot; // holds the newest image
+        uint16_t m_sequence;
+        bool m_dirty;
+        bool m_saved; // m_savedCrc is of what EEPROM holds
+        unsigned long m_changedMsec;
+        uint16_t m_savedCrc; // of the struct alone
+        uint32_t m_changes;
+        uint32_t m_commits;
+        uint32_t m_unchanged;
+};
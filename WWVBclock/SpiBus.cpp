@@ -0,0 +1,125 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include "SpiBus.h"
+#include "WwvbClockDefinitions.h"
+
+namespace SpiBus {
+namespace {
+    const uint8_t NO_PIN = 0xFF;
+
+    struct Device {
+        uint8_t irqPin = NO_PIN;
+        uint8_t activeLevel = LOW;
+        uint32_t pendingUsec = 0; // when its interrupt was first seen waiting. Zero if not
+        uint32_t transactions = 0;
+        uint32_t holdUsec = 0;
+        uint32_t holdMaxUsec = 0;
+        uint32_t waits = 0;
+        uint32_t waitUsec = 0;
+        uint32_t waitMaxUsec = 0;
+        uint32_t blocked = 0;
+    };
+    Device devices[NUM_DEVICES]; // every member initialized above
+    // ORDER MUST MATCH Device_t
+    const char * const DEVICE_NAMES[NUM_DEVICES] = { "Led", "Radio" };
+
+    Device_t holder = NUM_DEVICES;
+    uint32_t heldUsec;
+
+    void sample(uint32_t now)
+    {
+        for (uint8_t i = 0; i < NUM_DEVICES; i++)
+        {
+            auto &d = devices[i];
+            if (i != holder && d.irqPin != NO_PIN && d.pendingUsec == 0 &&
+                    digitalReadFast(d.irqPin) == d.activeLevel)
+                d.pendingUsec = now | 1; // never zero
+        }
+    }
+}
+
+void usingInterrupt(Device_t d, uint8_t irqPin, uint8_t activeLevel)
+{
+    devices[d].irqPin = irqPin;
+    devices[d].activeLevel = activeLevel;
+    SPI.usingInterrupt(digitalPinToInterrupt(irqPin));
+}
+
+void beginTransaction(Device_t d, const SPISettings &settings)
+{
+    SPI.beginTransaction(settings);
+    acquired(d);
+}
+
+void endTransaction(Device_t d)
+{
+    released(d);
+    SPI.endTransaction();
+}
+
+void acquired(Device_t d)
+{
+    holder = d;
+    heldUsec = micros();
+}
+
+void released(Device_t d)
+{
+    auto now = micros();
+    sample(now);
+    auto &h = devices[d];
+    uint32_t held = now - heldUsec;
+    h.transactions += 1;
+    h.holdUsec += held;
+    if (held > h.holdMaxUsec)
+        h.holdMaxUsec = held;
+    for (auto &w : devices)
+    {
+        if (w.pendingUsec == 0)
+            continue;
+        uint32_t waited = now - w.pendingUsec;
+        w.pendingUsec = 0;
+        w.waits += 1;
+        w.waitUsec += waited;
+        if (waited > w.waitMaxUsec)
+            w.waitMaxUsec = waited;
+        h.blocked += 1;
+    }
+    holder = NUM_DEVICES;
+}
+
+uint8_t transfer(uint8_t b)
+{
+    auto r = SPI.transfer(b);
+    sample(micros());
+    return r;
+}
+
+void print()
+{
+#if USE_SERIAL
+    Serial.println(F("SPI device transactions hold/max usec waits wait/max usec blocked"));
+    for (uint8_t i = 0; i < NUM_DEVICES; i++)
+    {
+        const auto &d = devices[i];
+        Serial.print(F("  "));
+        Serial.print(DEVICE_NAMES[i]);
+        Serial.print(' ');
+        Serial.print(d.transactions);
+        Serial.print(' ');
+        Serial.print(d.holdUsec);
+        Serial.print('/');
+        Serial.print(d.holdMaxUsec);
+        Serial.print(' ');
+        Serial.print(d.waits);
+        Serial.print(' ');
+        Serial.print(d.waitUsec);
+        Serial.print('/');
+        Serial.print(d.waitMaxUsec);
+        Serial.print(' ');
+        Serial.println(d.blocked);
+    }
+#endif
+}
+
+}
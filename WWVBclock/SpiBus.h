@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+class SPISettings;
+
+/* SpiBus accounts for the SPI bus the HCMS-290x LED and the RFM69 share.
+**
+** Arbitration is SPI.usingInterrupt: every transaction, whichever device owns it,
+** holds off the RFM69 interrupt until it ends. The radio's ISR is the only code that
+** wants the bus from interrupt context, so it never queues behind anything but the
+** one transaction in progress, and goes first when that ends. The cost is that
+** its FIFO read waits out the LED's transaction, which at the LED's 200KHz
+** SPI clock is the longest on the bus.
+**
+** SpiBus measures that. It keeps per device:
+**      hold    how long its transactions keep the bus
+**      wait    how long its interrupt was asserted while another device held the bus,
+**              sampled at each transfer() of that device
+**      blocked how many times its transaction held off another device's interrupt
+*/
+namespace SpiBus {
+    enum Device_t : uint8_t {LED, RADIO, NUM_DEVICES};
+
+    // device's interrupt pin is masked during every transaction on the bus
+    void usingInterrupt(Device_t, uint8_t irqPin, uint8_t activeLevel);
+    void beginTransaction(Device_t, const SPISettings &);
+    void endTransaction(Device_t);
+    // for a driver that begins its own transactions
+    void acquired(Device_t);
+    void released(Device_t);
+    // SPI.transfer, and notes any interrupt now waiting for the bus
+    uint8_t transfer(uint8_t);
+    void print();
+}
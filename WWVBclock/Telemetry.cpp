@@ -0,0 +1,95 @@
+#include <Arduino.h>
+#include "Telemetry.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    // a sync this long after the previous one says more about a missed sync than about drift
+    const uint32_t MAX_DRIFT_INTERVAL_SECONDS = 48ul * 3600;
+}
+
+Telemetry::Telemetry()
+    : m_periodSeconds(0)
+    , m_prevSentMsec(0)
+    , m_sequence(0)
+    , m_lastSyncUtc(0)
+    , m_driftErrorSeconds(0)
+    , m_driftIntervalSeconds(0)
+    , m_loopMaxMsec(0)
+{}
+
+void Telemetry::setPeriod(uint16_t seconds)
+{
+    m_periodSeconds = seconds;
+    m_prevSentMsec = millis();
+}
+
+void Telemetry::noteSync(time_t rtcBefore, time_t utc)
+{
+    if (m_lastSyncUtc != 0 && utc > m_lastSyncUtc)
+    {
+        uint32_t interval = utc - m_lastSyncUtc;
+        if (interval <= MAX_DRIFT_INTERVAL_SECONDS)
+        {
+            m_driftErrorSeconds += static_cast<int32_t>(rtcBefore - utc);
+            m_driftIntervalSeconds += interval;
+        }
+    }
+    m_lastSyncUtc = utc;
+}
+
+void Telemetry::restore(time_t lastSyncUtc, int32_t driftErrorSeconds, uint32_t driftIntervalSeconds)
+{
+    m_lastSyncUtc = lastSyncUtc;
+    m_driftErrorSeconds = driftErrorSeconds;
+    m_driftIntervalSeconds = driftIntervalSeconds;
+}
+
+void Telemetry::noteLoop(unsigned long msec)
+{
+    if (msec > m_loopMaxMsec)
+        m_loopMaxMsec = msec;
+}
+
+bool Telemetry::due(unsigned long now)
+{
+    if (m_periodSeconds == 0 || now - m_prevSentMsec < m_periodSeconds * 1000ul)
+        return false;
+    m_prevSentMsec = now;
+    return true;
+}
+
+int16_t Telemetry::driftTenthsPpm() const
+{
+    if (m_driftIntervalSeconds == 0)
+        return 0;
+    int64_t v = static_cast<int64_t>(m_driftErrorSeconds) * 10000000 / m_driftIntervalSeconds;
+    if (v > INT16_MAX) v = INT16_MAX;
+    if (v < INT16_MIN) v = INT16_MIN;
+    return static_cast<int16_t>(v);
+}
+
+void Telemetry::fill(TelemetryFrame::Status &s)
+{
+    s.sequence = m_sequence++;
+    s.lastSyncUtc = static_cast<uint32_t>(m_lastSyncUtc);
+    s.driftTenthsPpm = driftTenthsPpm();
+    s.loopMaxMsec = m_loopMaxMsec > 0xFFFFu ? 0xFFFFu : static_cast<uint16_t>(m_loopMaxMsec);
+    s.uptimeSeconds = millis() / 1000;
+    m_loopMaxMsec = 0;
+}
+
+void Telemetry::print() const
+{
+#if USE_SERIAL
+    Serial.print(F("Telemetry every "));
+    Serial.print(m_periodSeconds);
+    Serial.print(F(" seconds. Next sequence="));
+    Serial.print(static_cast<int>(m_sequence));
+    Serial.print(F(" drift tenths ppm="));
+    Serial.print(driftTenthsPpm());
+    Serial.print(F(" over "));
+    Serial.print(m_driftIntervalSeconds / 3600);
+    Serial.print(F(" hours. loop() max msec="));
+    Serial.println(m_loopMaxMsec);
+#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <TimeLib.h>
+#include "TelemetryFrame.h"
+
+/* Telemetry keeps the numbers that only the sketch's loop() sees, and decides
+** when the next status frame to the gateway is due.
+**
+** RTC drift is estimated at each WWVB sync, from how far the Teensy RTC had
+** drifted from WWVB since the previous sync. The RTC only reads whole seconds,
+** so errors and intervals are summed across all syncs since power up. The
+** rounding averages out as the sums grow.
+*/
+class Telemetry {
+    public:
+        Telemetry();
+        void setPeriod(uint16_t seconds); // zero for none
+        uint16_t period() const { return m_periodSeconds; }
+        void noteSync(time_t rtcBefore, time_t utc);
+        void noteLoop(unsigned long msec);
+        bool due(unsigned long now);
+        // fills the fields Telemetry owns, and starts a new loop() maximum
+        void fill(TelemetryFrame::Status &);
+        int16_t driftTenthsPpm() const;
+        // for the Journal, so the drift estimate survives a power cycle
+        time_t lastSyncUtc() const { return m_lastSyncUtc; }
+        int32_t driftErrorSeconds() const { return m_driftErrorSeconds; }
+        uint32_t driftIntervalSeconds() const { return m_driftIntervalSeconds; }
+        void restore(time_t lastSyncUtc, int32_t driftErrorSeconds, uint32_t driftIntervalSeconds);
+        void print() const;
+
+    protected:
+        uint16_t m_periodSeconds;
+        unsigned long m_prevSentMsec;
+        uint8_t m_sequence;
+        time_t m_lastSyncUtc;
+        int32_t m_driftErrorSeconds;
+        uint32_t m_driftIntervalSeconds;
+        unsigned long m_loopMaxMsec;
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+
+/* The status frame the clock sends to the gateway every Telemetry= seconds.
+** This header is shared with the host side TelemetryDecoder, so it uses nothing
+** from Arduino. Multi-byte fields are little endian, written byte by byte,
+** so neither side depends on struct packing.
+**
+** offset  size
+**   0      1   MAGIC. Not ASCII, so a gateway can tell it from a text message
+**   1      1   FORMAT_VERSION
+**   2      1   firmware major version
+**   3      1   firmware minor version
+**   4      1   sequence number, incremented every frame
+**   5      4   UTC of last WWVB sync. zero for none since power up
+**   9      2   WWVB searches since power up
+**  11      2   WWVB syncs since power up
+**  13      2   estimated RTC drift, tenths of ppm. positive is fast
+**  15      2   longest loop() since the previous frame, msec
+**  17      4   received frames dropped because the receive queue was full
+**  21      1   RSSI noise floor, dBm
+**  22      4   seconds since power up
+*/
+namespace TelemetryFrame {
+    const uint8_t MAGIC = 0xA5;
+    const uint8_t FORMAT_VERSION = 1;
+    const uint8_t FRAME_BYTES = 26;
+
+    struct Status {
+        uint8_t firmwareMajor;
+        uint8_t firmwareMinor;
+        uint8_t sequence;
+        uint32_t lastSyncUtc;
+        uint16_t searches;
+        uint16_t syncs;
+        int16_t driftTenthsPpm;
+        uint16_t loopMaxMsec;
+        uint32_t rxDropped;
+        int8_t noiseFloorDbm;
+        uint32_t uptimeSeconds;
+    };
+
+    namespace detail {
+        inline uint8_t *put(uint8_t *p, uint32_t v, int bytes)
+        {
+            for (int i = 0; i < bytes; i++, v >>= 8)
+                *p++ = static_cast<uint8_t>(v);
+            return p;
+        }
+        inline uint32_t get(const uint8_t *&p, int bytes)
+        {
+            uint32_t v = 0;
+            for (int i = 0; i < bytes; i++)
+                v |= static_cast<uint32_t>(*p++) << (8 * i);
+            return v;
+        }
+    }
+
+    // buf must hold FRAME_BYTES. returns FRAME_BYTES
+    inline uint8_t encode(const Status &s, uint8_t *buf)
+    {
+        using detail::put;
+        uint8_t *p = buf;
+        p = put(p, MAGIC, 1);
+        p = put(p, FORMAT_VERSION, 1);
+        p = put(p, s.firmwareMajor, 1);
+        p = put(p, s.firmwareMinor, 1);
+        p = put(p, s.sequence, 1);
+        p = put(p, s.lastSyncUtc, 4);
+        p = put(p, s.searches, 2);
+        p = put(p, s.syncs, 2);
+        p = put(p, static_cast<uint16_t>(s.driftTenthsPpm), 2);
+        p = put(p, s.loopMaxMsec, 2);
+        p = put(p, s.rxDropped, 4);
+        p = put(p, static_cast<uint8_t>(s.noiseFloorDbm), 1);
+        p = put(p, s.uptimeSeconds, 4);
+        return static_cast<uint8_t>(p - buf);
+    }
+
+    inline bool decode(const uint8_t *buf, unsigned len, Status &s)
+    {
+        using detail::get;
+        if (len < FRAME_BYTES || buf[0] != MAGIC || buf[1] != FORMAT_VERSION)
+            return false;
+        const uint8_t *p = buf + 2;
+        s.firmwareMajor = static_cast<uint8_t>(get(p, 1));
+        s.firmwareMinor = static_cast<uint8_t>(get(p, 1));
+        s.sequence = static_cast<uint8_t>(get(p, 1));
+        s.lastSyncUtc = get(p, 4);
+        s.searches = static_cast<uint16_t>(get(p, 2));
+        s.syncs = static_cast<uint16_t>(get(p, 2));
+        s.driftTenthsPpm = static_cast<int16_t>(get(p, 2));
+        s.loopMaxMsec = static_cast<uint16_t>(get(p, 2));
+        s.rxDropped = get(p, 4);
+        s.noiseFloorDbm = static_cast<int8_t>(get(p, 1));
+        s.uptimeSeconds = get(p, 4);
+        return true;
+    }
+}
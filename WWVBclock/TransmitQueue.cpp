@@ -0,0 +1,196 @@
+#include <Arduino.h>
+#include "TransmitQueue.h"
+#include "EventLog.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    const unsigned long FIRST_ACK_WAIT_MSEC = 40;
+    const unsigned long MAX_ACK_WAIT_MSEC = 500;
+    const unsigned long FIRST_CSMA_BACKOFF_MSEC = 2;
+    const unsigned long MAX_CSMA_BACKOFF_MSEC = 64;
+    // ORDER MUST MATCH TransmitQueue::Status_t
+    const char * const STATUS_NAMES[] = {"unknown", "pending", "sent", "acked", "failed"};
+
+    unsigned long ackWaitMsec(uint8_t retries)
+    {   // bounded exponential backoff
+        unsigned long w = FIRST_ACK_WAIT_MSEC << retries;
+        return w > MAX_ACK_WAIT_MSEC ? MAX_ACK_WAIT_MSEC : w;
+    }
+}
+
+TransmitQueue::TransmitQueue(QueuedRFM69 &radio)
+    : radio(radio)
+    , m_queue()
+    , m_first(0)
+    , m_count(0)
+    , m_nextSeq(1)
+    , m_state(IDLE)
+    , m_stateMsec(0)
+    , m_csmaBeganMsec(0)
+    , m_backoffMsec(0)
+    , m_destinations()
+    , m_nextDestination(0)
+    , m_completions()
+    , m_nextCompletion(0)
+{}
+
+uint16_t TransmitQueue::enqueue(uint8_t dest, const void *buf, uint8_t len, bool requestAck)
+{
+    if (m_count >= QUEUE_LENGTH || len > RF69_MAX_DATA_LEN)
+        return 0;
+    auto &m = m_queue[(m_first + m_count) % QUEUE_LENGTH];
+    m.seq = m_nextSeq++;
+    if (m_nextSeq == 0)
+        m_nextSeq = 1;
+    m.dest = dest;
+    m.len = len;
+    m.requestAck = requestAck;
+    m.retries = 0;
+    m.enqueuedMsec = millis();
+    memcpy(m.data, buf, len);
+    m_count += 1;
+    return m.seq;
+}
+
+TransmitQueue::Destination &TransmitQueue::destination(uint8_t node)
+{
+    for (auto &d : m_destinations)
+        if (d.node == node)
+            return d;
+    auto &d = m_destinations[m_nextDestination];
+    m_nextDestination = (m_nextDestination + 1) % NUM_DESTINATIONS;
+    d = Destination();
+    d.node = node;
+    return d;
+}
+
+void TransmitQueue::complete(Status_t s)
+{
+    auto &m = m_queue[m_first];
+    auto &d = destination(m.dest);
+    if (s == STATUS_FAILED)
+        d.failed += 1;
+    else if (s == STATUS_ACKED)
+    {
+        auto latency = millis() - m.enqueuedMsec;
+        d.acked += 1;
+        d.latencySumMsec += latency;
+        if (latency > d.latencyMaxMsec)
+            d.latencyMaxMsec = latency > 0xFFFFu ? 0xFFFFu : static_cast<uint16_t>(latency);
+    }
+    EventLog::log(EventLog::TRANSMIT_DONE, m.seq, s);
+    m_completions[m_nextCompletion] = {m.seq, s};
+    m_nextCompletion = (m_nextCompletion + 1) % NUM_COMPLETIONS;
+    m_first = (m_first + 1) % QUEUE_LENGTH;
+    m_count -= 1;
+    m_state = IDLE;
+}
+
+void TransmitQueue::loop()
+{
+    if (m_count == 0)
+        return;
+    auto &m = m_queue[m_first];
+    auto now = millis();
+    switch (m_state)
+    {
+        case WAIT_ACK:
+            if (radio.ackReceived(m.dest))
+            {
+                complete(STATUS_ACKED);
+                return;
+            }
+            if (now - m_stateMsec < ackWaitMsec(m.retries))
+                return;
+            if (m.retries >= MAX_RETRIES)
+            {
+                complete(STATUS_FAILED);
+                return;
+            }
+            m.retries += 1;
+            destination(m.dest).retries += 1;
+            m_state = IDLE;
+            break;
+        case WAIT_RETRY:
+            if (now - m_stateMsec < m_backoffMsec)
+                return;
+            break;
+        case IDLE:
+            break;
+    }
+    if (m_state == IDLE)
+    {
+        m_csmaBeganMsec = now;
+        m_backoffMsec = FIRST_CSMA_BACKOFF_MSEC;
+    }
+    bool csmaTimedOut = now - m_csmaBeganMsec >= RF69_CSMA_LIMIT_MS;
+    if (!radio.trySend(m.dest, m.data, m.len, m.requestAck, csmaTimedOut))
+    {   // channel busy. back off
+        if (m_state == WAIT_RETRY)
+            m_backoffMsec = m_backoffMsec * 2 > MAX_CSMA_BACKOFF_MSEC ? MAX_CSMA_BACKOFF_MSEC : m_backoffMsec * 2;
+        m_state = WAIT_RETRY;
+        m_stateMsec = now;
+        return;
+    }
+    auto &d = destination(m.dest);
+    d.sent += 1;
+    if (csmaTimedOut)
+        d.csmaTimeouts += 1;
+    if (!m.requestAck)
+    {
+        complete(STATUS_SENT);
+        return;
+    }
+    m_state = WAIT_ACK;
+    m_stateMsec = now;
+}
+
+TransmitQueue::Status_t TransmitQueue::status(uint16_t seq) const
+{
+    for (uint8_t i = 0; i < m_count; i++)
+        if (m_queue[(m_first + i) % QUEUE_LENGTH].seq == seq)
+            return STATUS_PENDING;
+    for (const auto &c : m_completions)
+        if (c.seq == seq)
+            return c.status;
+    return STATUS_UNKNOWN;
+}
+
+void TransmitQueue::printStatistics() const
+{
+#if USE_SERIAL
+    Serial.print(F("Transmit queue: pending="));
+    Serial.println(static_cast<int>(m_count));
+    for (const auto &d : m_destinations)
+    {
+        if (d.node == 0)
+            continue;
+        Serial.print(F("  node "));
+        Serial.print(static_cast<int>(d.node));
+        Serial.print(F(" sent="));
+        Serial.print(d.sent);
+        Serial.print(F(" acked="));
+        Serial.print(d.acked);
+        Serial.print(F(" failed="));
+        Serial.print(d.failed);
+        Serial.print(F(" retries="));
+        Serial.print(d.retries);
+        Serial.print(F(" csmaTimeouts="));
+        Serial.print(d.csmaTimeouts);
+        Serial.print(F(" latency avg/max msec="));
+        Serial.print(d.acked ? d.latencySumMsec / d.acked : 0);
+        Serial.print('/');
+        Serial.println(d.latencyMaxMsec);
+    }
+    for (uint8_t i = 0; i < NUM_COMPLETIONS; i++)
+    {
+        const auto &c = m_completions[(m_nextCompletion + i) % NUM_COMPLETIONS];
+        if (c.seq == 0)
+            continue;
+        Serial.print(F("  seq "));
+        Serial.print(c.seq);
+        Serial.print(' ');
+        Serial.println(STATUS_NAMES[c.status]);
+    }
+#endif
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include "QueuedRFM69.h"
+
+/* TransmitQueue sends radio messages without stalling loop().
+** enqueue() copies the message and returns at once. loop() sends one message at
+** a time, watches for its ACK, and retries with a doubling wait, up to MAX_RETRIES.
+** While the channel is busy, it backs off with a doubling wait too. After
+** RF69_CSMA_LIMIT_MS of a busy channel it sends anyway, as RFM69::send does.
+** The outcome of each message is kept by sequence number for status(),
+** and per destination counters track latency, retries and failures.
+*/
+class TransmitQueue {
+    public:
+        enum {QUEUE_LENGTH = 4, MAX_RETRIES = 3, NUM_DESTINATIONS = 4, NUM_COMPLETIONS = 8};
+        enum Status_t : uint8_t {STATUS_UNKNOWN, STATUS_PENDING, STATUS_SENT, STATUS_ACKED, STATUS_FAILED};
+
+        TransmitQueue(QueuedRFM69 &);
+        // returns the message's sequence number, or zero if the queue is full
+        uint16_t enqueue(uint8_t dest, const void *buf, uint8_t len, bool requestAck);
+        void loop();
+        Status_t status(uint16_t seq) const;
+        bool idle() const { return m_count == 0; }
+        void printStatistics() const;
+
+    protected:
+        struct Message {
+            uint16_t seq;
+            uint8_t dest;
+            uint8_t len;
+            bool requestAck;
+            uint8_t retries;
+            unsigned long enqueuedMsec;
+            uint8_t data[RF69_MAX_DATA_LEN];
+        };
+        struct Destination {
+            uint8_t node; // zero for unused
+            uint32_t sent;
+            uint32_t acked;
+            uint32_t failed;
+            uint32_t retries;
+            uint32_t csmaTimeouts; // sent after the channel stayed busy
+            uint32_t latencySumMsec; // of acked messages
+            uint16_t latencyMaxMsec;
+        };
+        struct Completion {
+            uint16_t seq;
+            Status_t status;
+        };
+        enum State_t {IDLE, WAIT_ACK, WAIT_RETRY};
+
+        void complete(Status_t);
+        Destination &destination(uint8_t node);
+        QueuedRFM69 &radio;
+        Message m_queue[QUEUE_LENGTH];
+        uint8_t m_first;
+        uint8_t m_count;
+        uint16_t m_nextSeq;
+        State_t m_state;
+        unsigned long m_stateMsec;
+        unsigned long m_csmaBeganMsec; // first attempt to send the head message
+        unsigned long m_backoffMsec; // while the channel is busy
+        Destination m_destinations[NUM_DESTINATIONS];
+        uint8_t m_nextDestination;
+        Completion m_completions[NUM_COMPLETIONS];
+        uint8_t m_nextCompletion;
+};
@@ -1,19 +1,6 @@
 #pragma once
-#include "HCMS290X.h"
 #include "WwvbClockDefinitions.h"
-
-enum Led_Font_enum {HCMS_OEM_FONT_IDX,     HCMS_SMALLDIG_FONT_IDX,        HCMS_7SEG_FONT_IDX, 
-                    FLIPPED_FONT_INCREMENT,
-                    HCMS_FLIPPED_OEM_FONT_IDX = FLIPPED_FONT_INCREMENT, HCMS_FLIPPED_SMALLDIG_FONT_IDX, HCMS_FLIPPED_7SEG_FONT_IDX, 
-                NUM_LED_FONTS};
-
-#if (DUAL_ROW_LED_DISPLAY == 0)
-typedef Hcms290X<LED_Hardware_e::SINGLE_ROW_OF_FOUR> Hcms290xType_t;
-#elif (FLIPPED_LED_UPDOWN == 0)
-typedef Hcms290X<LED_Hardware_e::DOUBLE_ROWS_OF_FOURS> Hcms290xType_t;
-#else
-typedef Hcms290X<LED_Hardware_e::DOUBLE_ROWS_OF_FOURS_FLIPPED_UPDOWN> Hcms290xType_t;
-#endif
+#include "ClockPolicy.h"
 
 class ClockNotification {
 public:
@@ -22,7 +9,7 @@ public:
     virtual void notifyRainmm(float)=0;
 };
 
- enum class ClockCommands_t {   // ORDER MUST MATCH CLOCKCOMMANDS ENTRIES
+ enum class ClockCommands_t {   // each has one entry in the command table in WWVBclock.ino
     ListCommands,
     TimeZoneOffset,
     ObserveDST,
@@ -51,14 +38,41 @@ public:
     PrintClock,
     PrintRadio,
     PrintParameters,
+    CpuGovernor,
+    PrintCpuClock,
+    Sensor,
+    PrintSensors,
+    History,
+    PrintReceiveQueue,
+    PrintTransmit,
+    RssiSurvey,
+    RadioQuiet,
+    PrintWwvbStats,
+    ListenMode,
+    Telemetry,
+    PrintJournal,
+    PrintBoot,
+    LoopBudgetMsec,
+    PrintLatency,
+    DumpLog,
+    LogLevel,
+    PrintMemory,
+    PrintTasks,
+    PrintSpi,
+    Es100FastI2c,
+    NUM_COMMANDS
  };
 
-extern const char * const CLOCKCOMMANDS[];
-
-extern void routeCommand(const char *cmd, uint8_t len, uint8_t senderid = -1, bool toMe = true);
+// returns false if nothing processed the command
+extern bool routeCommand(const char *cmd, uint8_t len, uint8_t senderid = -1, bool toMe = true);
+// a BinaryCommand frame. Returns the length of the reply
+extern uint8_t routeBinaryCommand(const uint8_t *frame, uint8_t len, uint8_t *reply, uint8_t replyMax);
+// range checks, stores and applies a setting the same as its text command
+extern bool applyClockCommand(ClockCommands_t, int32_t);
 extern void restoreAllSettings();
 extern int32_t aDecimalToInt(const char*& p);
 extern uint32_t aHexToInt(const char*&p);
+extern void requestCpuBurst();
 
 
 
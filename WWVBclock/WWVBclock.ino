@@ -46,11 +46,30 @@
 #include "ClockDisplay.h"
 #include "PacketWeather.h"
 #include "WWVBclock.h"
+#include "Buttons.h"
 #include "ClockSettings.h"
+#include "ClockGovernor.h"
+#include "SensorHistory.h"
+#include "ReceptionCoordinator.h"
+#include "Telemetry.h"
+#include "BinaryCommand.h"
+#include "CommandLineReader.h"
+#include "SettingsStore.h"
+#include "Journal.h"
+#include "WarmStart.h"
+#include "LoopMonitor.h"
+#include "EventLog.h"
+#include "MemoryReport.h"
+#include "Scheduler.h"
+#include "SpiBus.h"
 
 #define DIM(x) sizeof(x)/sizeof(x[0])
 
-#define WWVBCLOCK_VERSION "1.1"
+#define WWVBCLOCK_VERSION_MAJOR 1
+#define WWVBCLOCK_VERSION_MINOR 1
+#define WWVBCLOCK_STR(x) #x
+#define WWVBCLOCK_XSTR(x) WWVBCLOCK_STR(x)
+#define WWVBCLOCK_VERSION WWVBCLOCK_XSTR(WWVBCLOCK_VERSION_MAJOR) "." WWVBCLOCK_XSTR(WWVBCLOCK_VERSION_MINOR)
 
 // Teensy 4.0 pin assignments
 namespace {  
@@ -98,32 +117,87 @@ namespace {
  }
 
 namespace Settings {
-    /* EEPROM offsets to hold:
-    **     offset from UTC (in minutes, range: +/- 720)
-    **     whether to observe DST
+    /* Everything stored in EEPROM, kept as one image by a SettingsStore.
+    ** Members are ordered by size so the struct has no padding.
+    ** Add new members at the end, in place of reserved.
     */
-    // stored in EEPROM
-    uint32_t PacketIndoorTempIdMask;
-    uint32_t PacketOutdoorTempIdMask;
-    uint32_t PacketRaingaugeIdMask;
-    int16_t TimeZoneOffset; 
-    uint8_t observeDST;
-    uint8_t LedCurrent;
-    uint8_t LedPwm;
-    uint8_t dstInEffect;
-    uint8_t rotateLed180;
-    uint8_t unitsInMetric;
-    uint8_t TwelveHourDisplay;
-    uint8_t Es100Enable;
-    uint8_t TimeDisplayFont;
-    uint8_t UseFlippedFonts;
-    uint8_t Hcms290xEnable;
-    uint8_t TryRadioSilence;
-    uint8_t StartupDelaySeconds;
+    struct Image {
+        // The three masks are only read to initialize the SensorRegistry
+        uint32_t PacketIndoorTempIdMask;
+        uint32_t PacketOutdoorTempIdMask;
+        uint32_t PacketRaingaugeIdMask;
+        int16_t TimeZoneOffset; // minutes from UTC
+        uint16_t RainGaugeCorrection;
+        uint16_t ListenIdleMsec; // RFM69 ListenMode. zero for continuous receive
+        uint16_t ListenRxUsec;
+        uint16_t TelemetrySeconds; // status frame to the gateway. zero for none
+        uint8_t observeDST;
+        uint8_t LedCurrent;
+        uint8_t LedPwm;
+        uint8_t dstInEffect;
+        uint8_t rotateLed180;
+        uint8_t unitsInMetric;
+        uint8_t TwelveHourDisplay;
+        uint8_t Es100Enable;
+        uint8_t TimeDisplayFont;
+        uint8_t UseFlippedFonts;
+        uint8_t Hcms290xEnable;
+        uint8_t TryRadioSilence;
+        uint8_t StartupDelaySeconds;
+        uint8_t CpuGovernor;
+        uint8_t RadioQuiet;
+        uint8_t Es100FastI2c;
+        uint16_t LoopBudgetMsec; // at the end, not with the other uint16_t, to keep the older members in place
+    };
+    static_assert(sizeof(Image) == 40, "Settings::Image has padding");
+    Image image;
+    SettingsStore<Image> settingsStore(image);
+
+    uint32_t &PacketIndoorTempIdMask = image.PacketIndoorTempIdMask;
+    uint32_t &PacketOutdoorTempIdMask = image.PacketOutdoorTempIdMask;
+    uint32_t &PacketRaingaugeIdMask = image.PacketRaingaugeIdMask;
+    int16_t &TimeZoneOffset = image.TimeZoneOffset;
+    uint16_t &RainGaugeCorrection = image.RainGaugeCorrection;
+    uint16_t &ListenIdleMsec = image.ListenIdleMsec;
+    uint16_t &ListenRxUsec = image.ListenRxUsec;
+    uint16_t &TelemetrySeconds = image.TelemetrySeconds;
+    uint8_t &observeDST = image.observeDST;
+    uint8_t &LedCurrent = image.LedCurrent;
+    uint8_t &LedPwm = image.LedPwm;
+    uint8_t &dstInEffect = image.dstInEffect;
+    uint8_t &rotateLed180 = image.rotateLed180;
+    uint8_t &unitsInMetric = image.unitsInMetric;
+    uint8_t &TwelveHourDisplay = image.TwelveHourDisplay;
+    uint8_t &Es100Enable = image.Es100Enable;
+    uint8_t &TimeDisplayFont = image.TimeDisplayFont;
+    uint8_t &UseFlippedFonts = image.UseFlippedFonts;
+    uint8_t &Hcms290xEnable = image.Hcms290xEnable;
+    uint8_t &TryRadioSilence = image.TryRadioSilence;
+    uint8_t &StartupDelaySeconds = image.StartupDelaySeconds;
+    uint8_t &CpuGovernor = image.CpuGovernor;
+    uint8_t &RadioQuiet = image.RadioQuiet;
+    uint8_t &Es100FastI2c = image.Es100FastI2c;
+    uint16_t &LoopBudgetMsec = image.LoopBudgetMsec;
+
     const uint8_t STARTUP_DELAY_MAX_SECONDS = 50;
-    uint16_t RainGaugeCorrection;
+    const uint16_t LOOP_BUDGET_DEFAULT_MSEC = 1000;
+    const int16_t TIME_ZONE_MIN_MINUTES = -12 * 60;
+    const int16_t TIME_ZONE_MAX_MINUTES = 14 * 60;
+    const uint16_t RAIN_GAUGE_CORRECTION_MIN = 500; // per thousand
+    const uint16_t RAIN_GAUGE_CORRECTION_MAX = 2000;
+    const uint16_t RAIN_GAUGE_CORRECTION_DEFAULT = 1000;
+    const uint8_t LED_CURRENT_MAX = 3;
+    const uint8_t LED_CURRENT_DEFAULT = 2; // the HCMS-290x power up current
+    const uint8_t LED_PWM_MAX = 15;
+    /* The RX window holds a sender's preamble and sync word. Catching a packet in ListenMode
+    ** also takes a preamble longer than idle plus RX, which the RFM69 library's default
+    ** 3 bytes, 432 usec, is not: the idle time is at least 4.1 msec.
+    ** Senders need a longer preamble, or to burst their packets. See LISTEN_SENDER_PREAMBLE_BYTES */
+    const uint16_t LISTEN_RX_DEFAULT_USEC = QueuedRFM69::LISTEN_RX_DEFAULT_USEC;
 
-   enum class EepromAddresses {WWVBCLOCK_START = (~0x7u & (7 + RadioConfiguration::EepromAddresses::TOTAL_EEPROM_USED)),
+    /* Before the SettingsStore, each setting had its own EEPROM address.
+    ** The image now starts at WWVBCLOCK_START, and these are read only to migrate an older clock. */
+    enum class EepromAddresses {WWVBCLOCK_START = (~0x7u & (7 + RadioConfiguration::EepromAddresses::TOTAL_EEPROM_USED)),
         PACKET_INDOOR_THERMOMETER_MASK = WWVBCLOCK_START,
         PACKET_OUTDOOR_THERMOMETER_MASK = PACKET_INDOOR_THERMOMETER_MASK + sizeof(PacketIndoorTempIdMask),
         PACKET_RAINGAUGE_MASK = PACKET_OUTDOOR_THERMOMETER_MASK + sizeof(PacketOutdoorTempIdMask),
@@ -142,8 +216,23 @@ namespace Settings {
         TRY_RADIO_SILENCE = HCMS290x_ENABLE + sizeof(Hcms290xEnable),
         STARTUP_DELAY_SECONDS = TRY_RADIO_SILENCE + sizeof(TryRadioSilence),
         RAINGAUGE_CORRECTION = STARTUP_DELAY_SECONDS + sizeof(StartupDelaySeconds),
-        TOTAL_EEPROM_USED = RAINGAUGE_CORRECTION + sizeof(RainGaugeCorrection),
+        CPU_GOVERNOR = RAINGAUGE_CORRECTION + sizeof(RainGaugeCorrection),
+        RADIO_QUIET = CPU_GOVERNOR + sizeof(CpuGovernor),
+        LISTEN_IDLE_MSEC = RADIO_QUIET + sizeof(RadioQuiet),
+        LISTEN_RX_USEC = LISTEN_IDLE_MSEC + sizeof(ListenIdleMsec),
+        TELEMETRY_SECONDS = LISTEN_RX_USEC + sizeof(ListenRxUsec),
+        SETTINGS_IMAGE = WWVBCLOCK_START,
+        SETTINGS_IMAGE_END = SETTINGS_IMAGE + SettingsStore<Image>::SLOT_BYTES,
+        // the registry stays put when settings are added
+        SENSOR_REGISTRY = WWVBCLOCK_START + 64,
+        SENSOR_REGISTRY_END = SENSOR_REGISTRY + SensorRegistry::EEPROM_BYTES_USED,
+        // the Journal takes the rest, but for the second settings slot at the very end
+        JOURNAL = SENSOR_REGISTRY_END,
+        SETTINGS_IMAGE_B = E2END + 1 - SettingsStore<Image>::SLOT_BYTES,
+        JOURNAL_END = SETTINGS_IMAGE_B,
     };
+    static_assert(static_cast<unsigned>(EepromAddresses::SETTINGS_IMAGE_END) <= static_cast<unsigned>(EepromAddresses::SENSOR_REGISTRY), "Settings overlap SensorRegistry");
+    static_assert(static_cast<unsigned>(EepromAddresses::SENSOR_REGISTRY_END) <= E2END + 1, "SensorRegistry exceeds EEPROM");
 }
 
 namespace {
@@ -159,7 +248,7 @@ namespace {
 
 namespace {
     // WWVB receiver on 2wire interface (aka i2c).
-    Es100Wire es100Wire(ES100_NIRQ_PIN, ES100_EN_PIN, Wire1);
+    Es100Wire es100Wire(ES100_NIRQ_PIN, ES100_EN_PIN, Wire1, SCL1_PIN, SDA1_PIN);
     time_t getTeensy3Time() {  return Teensy3Clock.get();    } 
     
     /* Keeping the battery backed up Teensy3Time up to date with the WWVB receiver:
@@ -185,42 +274,99 @@ namespace {
 
 namespace {
     // HCMS290x 4 character LED display. Optionally a second one below the first
-    const Raster5x7Font *fonts[NUM_LED_FONTS] =
-    {   // ORDER in array MUST MATCH enum Led_Font_enum
-        &gOem5x7Font,
-        &gSmallDigits5x7Font,
-        &gDigits7Seg5x7Font,
-        &gOem5x7FontFlipped,
-        &gSmallDigits5x7FontFlipped,
-        &gDigits7Seg5x7FontFlipped,
-
-    };
+    const Raster5x7Font **fonts = ClockPolicy_t::fonts;
     Hcms290xType_t hcms290X(P_LED_NENABLE_PIN, P_LED_RS_PIN, P_LED_BLANK_PIN, P_LED_RESET_PIN,
         NUM_LED_FONTS, fonts);
 
     ClockDisplay clockDisplay(lcd, hcms290X);
-    ClockSettings clockSettings(lcd);
+    Buttons buttons(SW1_INPUT_PIN, SW2_INPUT_PIN);
+    ClockSettings clockSettings(lcd, buttons);
+    ClockGovernor clockGovernor;
+    ReceptionCoordinator receptionCoordinator;
+    Telemetry telemetry;
+    Journal journal;
+    WarmStart warmStart;
+
+    // loop() runs these through the Scheduler. Each is defined with loop() below
+    enum Task_t : uint8_t {TASK_RADIO, TASK_WWVB, TASK_POWER, TASK_SERIAL, TASK_DISPLAY, TASK_HOUSEKEEPING, NUM_TASKS};
+    // ORDER MUST MATCH Task_t
+    const char * const TASK_NAMES[NUM_TASKS] = { "Radio", "Wwvb", "Power", "Serial", "Display", "Housekeeping" };
+    bool runRadio();
+    bool runWwvb();
+    bool runPower();
+    bool runSerial();
+    bool runDisplay();
+    bool runHousekeeping();
+    bool radioPending();
+    bool es100Pending();
+    bool buttonsPending();
+    bool serialPending();
+    // ORDER MUST MATCH Task_t. Lower priority runs first, and a yielded task waits for any that became ready
+    const Scheduler::Task TASKS[NUM_TASKS] = {
+        // priority, period msec, budget usec, run, ready
+        { 0, 10, 20000, runRadio, radioPending },
+        { 1, 50, 5000, runWwvb, es100Pending },
+        { 2, 50, 500, runPower, nullptr },
+        { 3, 50, 10000, runSerial, serialPending },
+        { 4, 20, 4000, runDisplay, buttonsPending },
+        { 5, 100, 2000, runHousekeeping, nullptr },
+    };
+    // the LoopMonitor's last probe is the task that was running at a watchdog reset
+    LoopMonitor loopMonitor(TASK_NAMES, NUM_TASKS);
+    void probeTask(uint8_t task) { loopMonitor.probe(task); }
+    Scheduler scheduler(TASKS, TASK_NAMES, NUM_TASKS, probeTask);
+    SensorHistory sensorHistory;
 
     bool radioSilence;
     void beginRadioSilence()
     {
-#if USE_SERIAL
         if (!radioSilence)
-            Serial.println("Starting radio silence");
-#endif
+            EventLog::log(EventLog::RADIO_SILENCE, 1);
         radioSilence = true;
         clockDisplay.setRadioSilence(radioSilence);
     }
     void endRadioSilence()
     {
+        if (radioSilence)
+            EventLog::log(EventLog::RADIO_SILENCE, 0);
         radioSilence = false;
         clockDisplay.setRadioSilence(radioSilence);
     }
 
-    const int CMD_BUFLEN = 80;
-    char cmdbuf[CMD_BUFLEN];
+#if USE_SERIAL
+    CommandLineReader serialCommands(Serial);
+#endif
+
+    /* RAM budgets for the largest statics, in bytes. PrintMemory shows what they use.
+    ** Raise a budget only after checking that the Teensy has the room. */
+    static_assert(sizeof(packetWeather) <= 8192, "packetWeather grew past its RAM budget");
+    static_assert(sizeof(sensorHistory) <= 10240, "sensorHistory grew past its RAM budget");
+    static_assert(sizeof(warmStart) <= 6144, "warmStart grew past its RAM budget");
+    static_assert(sizeof(hcms290X) <= 256, "hcms290X grew past its RAM budget");
+    static_assert(sizeof(clockDisplay) <= 256, "clockDisplay grew past its RAM budget");
+    static_assert(sizeof(journal) <= 256, "journal grew past its RAM budget");
+    static_assert(sizeof(loopMonitor) <= 256, "loopMonitor grew past its RAM budget");
+#if USE_SERIAL
+    static_assert(sizeof(serialCommands) <= 512, "serialCommands grew past its RAM budget");
+#endif
  }
 
+namespace Boot {
+    /* setup() shows the RTC time, then loop() runs these in order, one per pass.
+    ** Times are millis(), which counts from reset */
+    enum Stage_t {STARTUP_DELAY, RADIO, ES100, REPORT, RUNNING};
+    // ORDER MUST MATCH Stage_t
+    const char * const STAGE_NAMES[RUNNING] = { "StartupDelay", "Radio", "Es100", "Report" };
+    Stage_t stage;
+    unsigned long setupBeganMsec;
+    unsigned long firstFrameMsec;
+    unsigned long stageBeganMsec;
+    unsigned long stageDoneMsec[RUNNING];
+    uint8_t journalKeys;
+    bool warm; // resumed from the WarmStart snapshot. Skips the StartupDelay stage
+    const unsigned long SERIAL_SETTLE_MSEC = 100; // was a delay() after Serial.begin()
+}
+
  using namespace Settings;
 
 static void printParameters()
@@ -252,20 +398,37 @@ static void printParameters()
     Serial.println(static_cast<int>(LedCurrent));
     Serial.print(F("Led PWM:"));
     Serial.println(static_cast<int>(LedPwm));
+    auto &sensors = packetWeather.sensors();
     Serial.print(F("Indoor thermometers: 0x"));
-    Serial.println(PacketIndoorTempIdMask, HEX);
+    Serial.println(sensors.mask(SensorRegistry::ROLE_INDOOR_TEMP), HEX);
     Serial.print(F("Outdoor thermometers: 0x"));
-    Serial.println(PacketOutdoorTempIdMask, HEX);
+    Serial.println(sensors.mask(SensorRegistry::ROLE_OUTDOOR_TEMP), HEX);
     Serial.print(F("Raingauge mask: 0x"));
-    Serial.println(PacketRaingaugeIdMask, HEX);
+    Serial.println(sensors.mask(SensorRegistry::ROLE_RAINGAUGE), HEX);
+    sensors.print();
     Serial.print(F("StartupDelaySeconds="));
     Serial.println(static_cast<int>(StartupDelaySeconds));
     Serial.print(F("RainGaugeCorrection="));
     Serial.println(RainGaugeCorrection);
+    Serial.print(F("CpuGovernor="));
+    Serial.println(static_cast<int>(CpuGovernor));
+    Serial.print(F("RadioQuiet="));
+    Serial.println(static_cast<int>(RadioQuiet));
+    Serial.print(F("ListenMode="));
+    Serial.print(ListenIdleMsec);
+    Serial.print(',');
+    Serial.println(ListenRxUsec);
+    Serial.print(F("Telemetry="));
+    Serial.println(TelemetrySeconds);
+    Serial.print(F("LoopBudgetMsec="));
+    Serial.println(LoopBudgetMsec);
+    Serial.print(F("Es100FastI2c="));
+    Serial.println(static_cast<int>(Es100FastI2c));
+    settingsStore.print();
 #endif
 }
 
-void restoreAllSettings()
+static void readLegacySettings()
 {
     EEPROM.get(static_cast<uint16_t>(EepromAddresses::TIME_ZONE_OFFSET), TimeZoneOffset);
     EEPROM.get(static_cast<uint16_t>(EepromAddresses::OBSERVE_DST), observeDST);
@@ -284,44 +447,159 @@ void restoreAllSettings()
     EEPROM.get(static_cast<uint16_t>(EepromAddresses::USE_FLIPPED_FONTS), UseFlippedFonts);
     EEPROM.get(static_cast<uint16_t>(EepromAddresses::TRY_RADIO_SILENCE), TryRadioSilence);
     EEPROM.get(static_cast<uint16_t>(EepromAddresses::STARTUP_DELAY_SECONDS), StartupDelaySeconds);
-    if (StartupDelaySeconds > STARTUP_DELAY_MAX_SECONDS) StartupDelaySeconds = STARTUP_DELAY_MAX_SECONDS;
     EEPROM.get(static_cast<uint16_t>(EepromAddresses::RAINGAUGE_CORRECTION), RainGaugeCorrection);
- }
+    EEPROM.get(static_cast<uint16_t>(EepromAddresses::CPU_GOVERNOR), CpuGovernor);
+    EEPROM.get(static_cast<uint16_t>(EepromAddresses::RADIO_QUIET), RadioQuiet);
+    EEPROM.get(static_cast<uint16_t>(EepromAddresses::LISTEN_IDLE_MSEC), ListenIdleMsec);
+    EEPROM.get(static_cast<uint16_t>(EepromAddresses::LISTEN_RX_USEC), ListenRxUsec);
+    EEPROM.get(static_cast<uint16_t>(EepromAddresses::TELEMETRY_SECONDS), TelemetrySeconds);
+}
 
-void setup()
+void restoreAllSettings()
 {
-    if (StartupDelaySeconds > 0)
-        delay(1000 * StartupDelaySeconds);
+    switch (settingsStore.load(static_cast<uint16_t>(EepromAddresses::SETTINGS_IMAGE),
+            static_cast<uint16_t>(EepromAddresses::SETTINGS_IMAGE_B)))
+    {
+        case SettingsStore<Image>::LOADED:
+            break;
+        case SettingsStore<Image>::NO_IMAGE:
+        case SettingsStore<Image>::BAD_IMAGE:
+            /* An older clock has its settings at the legacy addresses. If both slots are bad,
+            ** those are likely overwritten, but the checks below discard what doesn't make sense. */
+            memset(&image, 0xFF, sizeof(image));
+            readLegacySettings();
+            settingsStore.changed();
+            break;
+    }
+    /* Range check every member, whatever its source. Members added since the image was
+    ** written, and never programmed EEPROM, read as all bits set. */
+    auto yesNo = [](uint8_t &v, uint8_t dflt) { if (v > 1) v = dflt; };
+    if (PacketIndoorTempIdMask == 0xFFFFFFFFu) PacketIndoorTempIdMask = 0;
+    if (PacketOutdoorTempIdMask == 0xFFFFFFFFu) PacketOutdoorTempIdMask = 0;
+    if (PacketRaingaugeIdMask == 0xFFFFFFFFu) PacketRaingaugeIdMask = 0;
+    // all bits set is -1, which is in range, but is no time zone anyone uses
+    if (TimeZoneOffset == -1 || TimeZoneOffset < TIME_ZONE_MIN_MINUTES || TimeZoneOffset > TIME_ZONE_MAX_MINUTES)
+        TimeZoneOffset = 0;
+    if (RainGaugeCorrection < RAIN_GAUGE_CORRECTION_MIN || RainGaugeCorrection > RAIN_GAUGE_CORRECTION_MAX)
+        RainGaugeCorrection = RAIN_GAUGE_CORRECTION_DEFAULT;
+    if (ListenIdleMsec > QueuedRFM69::LISTEN_IDLE_MAX_MSEC) ListenIdleMsec = 0;
+    if (ListenRxUsec > QueuedRFM69::LISTEN_RX_MAX_USEC) ListenRxUsec = LISTEN_RX_DEFAULT_USEC;
+    if (!QueuedRFM69::listenCovered(ListenIdleMsec, ListenRxUsec)) ListenIdleMsec = 0;
+    if (TelemetrySeconds == 0xFFFFu) TelemetrySeconds = 0;
+    yesNo(observeDST, 0);
+    if (LedCurrent > LED_CURRENT_MAX) LedCurrent = LED_CURRENT_DEFAULT;
+    if (LedPwm > LED_PWM_MAX) LedPwm = LED_PWM_MAX;
+    yesNo(dstInEffect, 0);
+    yesNo(rotateLed180, 0);
+    yesNo(unitsInMetric, 0);
+    yesNo(TwelveHourDisplay, 0);
+    yesNo(Es100Enable, 1);
+    if (TimeDisplayFont >= static_cast<uint8_t>(ClockDisplay::TimeDisplaySyle::DISPLAY_STYLE_MAX)) TimeDisplayFont = 0;
+    yesNo(UseFlippedFonts, 0);
+    yesNo(Hcms290xEnable, 1);
+    yesNo(TryRadioSilence, 0);
+    if (StartupDelaySeconds > STARTUP_DELAY_MAX_SECONDS) StartupDelaySeconds = STARTUP_DELAY_MAX_SECONDS;
+    yesNo(CpuGovernor, 0);
+    if (RadioQuiet >= ReceptionCoordinator::NUM_MODES) RadioQuiet = ReceptionCoordinator::MODE_OFF;
+    yesNo(Es100FastI2c, 0);
+    // the watchdog can't be turned off, so there is no zero. This was reserved, and might be zero or 0xFFFF
+    if (LoopBudgetMsec < LoopMonitor::MIN_BUDGET_MSEC || LoopBudgetMsec > LoopMonitor::MAX_BUDGET_MSEC)
+        LoopBudgetMsec = LOOP_BUDGET_DEFAULT_MSEC;
+}
+
+static time_t journalTime(Journal::Key_t k)
+{
+    return static_cast<time_t>(static_cast<uint32_t>(journal.value(k)));
+}
+
+// after the clock's time, time zone and DST are set
+static void restoreFromJournal()
+{
+    if (journal.has(Journal::RAIN_UTC))
+        clockDisplay.restoreRain(journal.value(Journal::RAIN_TODAY) / 100.f,
+            journal.value(Journal::RAIN_YESTERDAY) / 100.f, journalTime(Journal::RAIN_UTC));
+    if (journal.has(Journal::LAST_SYNC_UTC))
+    {
+        auto utc = journalTime(Journal::LAST_SYNC_UTC);
+        telemetry.restore(utc, journal.value(Journal::DRIFT_ERROR_SECONDS),
+            static_cast<uint32_t>(journal.value(Journal::DRIFT_INTERVAL_SECONDS)));
+        clockSettings.es100UpdatedAt(utc);
+    }
+}
+
+static void restoreWarmState()
+{   // a watchdog or software reset. Carry on as before it
+    const auto &w = warmStart.restored();
+    wwvbSynced = w.wwvbSynced != 0;
+    wwvbSyncTimeMsec = warmStart.rebase(w.wwvbSyncTimeMsec);
+    wwvbSearchStartedMsec = warmStart.rebase(w.wwvbSearchStartedMsec);
+    dstInEffect = w.dstInEffect;
+    es100Wire.restoreDstStatus(w.es100);
+    clockDisplay.restoreDst(w.dst != 0, w.dstScheduledBegin != 0, w.dstChangesWhen);
+    clockDisplay.restoreRain(w.rainToday, w.rainYesterday, now());
+    auto &sensors = packetWeather.sensors();
+    for (int id = 0; id < SensorRegistry::NUM_NODE_IDS; id++)
+    {
+        auto &e = sensors.entry(static_cast<uint8_t>(id));
+        e = w.sensors[id];
+        e.lastSeenMsec = warmStart.rebase(e.lastSeenMsec);
+    }
+}
+
+static void saveWarmState()
+{
+    auto &w = warmStart.staging();
+    w.wwvbSyncTimeMsec = wwvbSyncTimeMsec;
+    w.wwvbSearchStartedMsec = wwvbSearchStartedMsec;
+    w.dstChangesWhen = clockDisplay.dstChangesWhen();
+    w.rainToday = clockDisplay.rainToday();
+    w.rainYesterday = clockDisplay.rainYesterday();
+    w.es100 = es100Wire.dstStatus();
+    w.wwvbSynced = wwvbSynced ? 1 : 0;
+    w.dstInEffect = dstInEffect;
+    w.dst = clockDisplay.dst() ? 1 : 0;
+    w.dstScheduledBegin = clockDisplay.dstScheduledBegin() ? 1 : 0;
+    const auto &sensors = packetWeather.sensors();
+    for (int id = 0; id < SensorRegistry::NUM_NODE_IDS; id++)
+        w.sensors[id] = sensors.entry(static_cast<uint8_t>(id));
+    warmStart.save();
+}
+
+static void journalRain()
+{   // rain totals change with a rain gauge report, and at local midnight and noon
+    auto today = static_cast<int32_t>(lroundf(clockDisplay.rainToday() * 100));
+    auto yesterday = static_cast<int32_t>(lroundf(clockDisplay.rainYesterday() * 100));
+    if (journal.has(Journal::RAIN_UTC) &&
+        journal.value(Journal::RAIN_TODAY) == today &&
+        journal.value(Journal::RAIN_YESTERDAY) == yesterday)
+        return;
+    journal.write(Journal::RAIN_TODAY, today);
+    journal.write(Journal::RAIN_YESTERDAY, yesterday);
+    journal.write(Journal::RAIN_UTC, static_cast<int32_t>(now()));
+}
+
+void setup()
+{   /* Only what it takes to put the RTC time on the LCD and LED runs here.
+    ** The radio, the ES100 and StartupDelaySeconds are deferred to bootStages() in loop() */
+    MemoryReport::paintStack();
+    Boot::setupBeganMsec = millis();
+    loopMonitor.setup();
+    EventLog::setup(loopMonitor.resetReason());
     restoreAllSettings();
+    Boot::journalKeys = journal.setup(static_cast<uint16_t>(EepromAddresses::JOURNAL), static_cast<uint16_t>(EepromAddresses::JOURNAL_END));
+    if (journal.has(Journal::DST_IN_EFFECT)) // WWVB may have changed it since the settings were saved
+        dstInEffect = static_cast<uint8_t>(journal.value(Journal::DST_IN_EFFECT));
     // when using SPI on more than one device, it is crucial to set all their Slave Select pins HIGH before SPI.begin()
     pinMode(RFM69_NSS_PIN, OUTPUT);
     digitalWrite(RFM69_NSS_PIN, HIGH);
     pinMode(P_LED_NENABLE_PIN, OUTPUT);
     digitalWrite(P_LED_NENABLE_PIN, HIGH);
     SPI.begin(); // sets the SPI pins in their Input/output state. Leave them that way
-    packetWeather.setup();
     setSyncProvider(getTeensy3Time);
 #if USE_SERIAL
-    Serial.begin(115200);
-    delay(100);
-    Serial.println("Wwvb Clock version " WWVBCLOCK_VERSION);
+    Serial.begin(115200); // nothing printed until the REPORT stage gives USB time to enumerate
 #endif
 
-    // deal with possibility that the EEPROM is its unitialized all-bits-set state
-    if (TimeZoneOffset == 0xFFFFu) // EEPROM unitialized?
-        TimeZoneOffset = 0;
-    if (observeDST == 0xFFu)
-        observeDST = 0;
-    if (PacketIndoorTempIdMask == 0xFFFFFFFFu)
-        PacketIndoorTempIdMask = 0;
-    if (PacketOutdoorTempIdMask == 0xFFFFFFFFu)
-        PacketOutdoorTempIdMask = 0;
-    if (PacketRaingaugeIdMask == 0xFFFFFFFFu)
-        PacketRaingaugeIdMask = 0;
-
-    printParameters();
-
-    es100Wire.setup(Es100Enable);  
     hcms290X.setup(Hcms290xEnable);
     hcms290X.setLedCurrent(LedCurrent);
     hcms290X.setledPWM(LedPwm);
@@ -332,26 +610,35 @@ void setup()
     clockDisplay.setDisplayStyle(static_cast<ClockDisplay::TimeDisplaySyle>(TimeDisplayFont));
     clockDisplay.useFlippedFonts(UseFlippedFonts != 0); 
     clockDisplay.setRainGaugeCorrection(RainGaugeCorrection);
-    packetWeather.radioPrintInfo();
-    packetWeather.SetThermometerIdMasks(PacketIndoorTempIdMask, PacketOutdoorTempIdMask);
-    packetWeather.SetRaingaugeIdMask(PacketRaingaugeIdMask);
 
-    pinMode(SW1_INPUT_PIN, INPUT_PULLUP);
-    pinMode(SW2_INPUT_PIN, INPUT_PULLUP);
+    buttons.setup();
  
     auto teensyNow = Teensy3Clock.get();
     setTime(teensyNow);
-    DEBUG_OUTPUT1(F("Teensy time now:"));
-    DEBUG_OUTPUT1(teensyNow);
-    DEBUG_OUTPUT1('\n');
     clockDisplay.setDST(dstInEffect && observeDST);
     clockDisplay.unitsInMetric(unitsInMetric != 0);
     clockDisplay.set12Hour(TwelveHourDisplay != 0);
+    while (clockDisplay.loop(true, true)); // both LCD lines
+    Boot::firstFrameMsec = millis();
+
+    if (!packetWeather.sensors().setup(static_cast<uint16_t>(EepromAddresses::SENSOR_REGISTRY)))
+    {   // first run with a SensorRegistry. Take the roles from the masks
+        auto &sensors = packetWeather.sensors();
+        sensors.setFromMask(SensorRegistry::ROLE_RAINGAUGE, PacketRaingaugeIdMask);
+        sensors.setFromMask(SensorRegistry::ROLE_OUTDOOR_TEMP, PacketOutdoorTempIdMask);
+        sensors.setFromMask(SensorRegistry::ROLE_INDOOR_TEMP, PacketIndoorTempIdMask);
+    }
     packetWeather.setNotify(&clockDisplay);
     wwvbSearchStartedMsec = millis();
-#if USE_SERIAL
-    Serial.println(F("setup() complete"));
-#endif
+    clockGovernor.setup(CpuGovernor != 0);
+    receptionCoordinator.setMode(static_cast<ReceptionCoordinator::Mode_t>(RadioQuiet));
+    telemetry.setPeriod(TelemetrySeconds);
+    restoreFromJournal();
+    Boot::warm = warmStart.setup() == WarmStart::WARM;
+    if (Boot::warm)
+        restoreWarmState();
+    Boot::stage = Boot::STARTUP_DELAY;
+    Boot::stageBeganMsec = millis();
 }
 
 static void dstScheduleFromWwvbToClock()
@@ -366,430 +653,890 @@ static void dstScheduleFromWwvbToClock()
     }
 }
 
-static bool compareCommand(const char *p, const char *&incoming)
+static bool yesNo(const char *cmd)
 {
-    const char *q = incoming;
-    for (;;)
+    auto c = cmd[0];
+    return c == 'Y' || c == 'y' || c == '1';
+}
+
+/* The apply functions put a setting into effect. The command table has already
+** range checked it and stored it in its Settings variable. Returning false puts
+** the previous value back and leaves EEPROM alone. */
+static bool applyTimeZoneOffset(int32_t)
+{
+    DEBUG_OUTPUT1("TimeZoneOffset=");
+    DEBUG_OUTPUT1(TimeZoneOffset);
+    DEBUG_OUTPUT1('\n');
+    clockDisplay.setUtcMinutesOffset(TimeZoneOffset);
+    return true;
+}
+
+static bool applyObserveDst(int32_t)
+{
+    clockDisplay.setDST(dstInEffect && observeDST);
+    dstScheduleFromWwvbToClock();
+    return true;
+}
+
+static bool applyLedCurrent(int32_t)
+{
+    hcms290X.setLedCurrent(LedCurrent);
+    return true;
+}
+
+static bool applyLedPwm(int32_t)
+{
+    hcms290X.setledPWM(LedPwm);
+    return true;
+}
+
+static bool applyDstIsInEffect(int32_t)
+{
+    journal.write(Journal::DST_IN_EFFECT, dstInEffect);
+    clockDisplay.setDST(dstInEffect && observeDST);
+    return true;
+}
+
+static bool applyTime(int32_t v)
+{
+    auto utc = static_cast<time_t>(static_cast<uint32_t>(v));
+    DEBUG_OUTPUT1(F("As set:"));
+    DEBUG_OUTPUT1(utc);
+    DEBUG_OUTPUT1('\n');
+    Teensy3Clock.set(utc);
+    setTime(utc);
+    return true;
+}
+
+static bool applyRotateLed180(int32_t)
+{
+    hcms290X.setRotate180(rotateLed180 != 0);
+    clockDisplay.updateDisplay();
+    return true;
+}
+
+// The mask commands set the SensorRegistry roles of node IDs 1 through 32
+static bool applyIndoorThermometerMask(int32_t v)
+{
+    packetWeather.sensors().setFromMask(SensorRegistry::ROLE_INDOOR_TEMP, static_cast<uint32_t>(v));
+    return true;
+}
+
+static bool applyOutdoorThermometerMask(int32_t v)
+{
+    packetWeather.sensors().setFromMask(SensorRegistry::ROLE_OUTDOOR_TEMP, static_cast<uint32_t>(v));
+    return true;
+}
+
+static bool applyRaingaugeMask(int32_t v)
+{
+    packetWeather.sensors().setFromMask(SensorRegistry::ROLE_RAINGAUGE, static_cast<uint32_t>(v));
+    return true;
+}
+
+static bool applyMetricUnits(int32_t)
+{
+    clockDisplay.unitsInMetric(unitsInMetric != 0);
+    return true;
+}
+
+static bool apply12HourDisplay(int32_t)
+{
+    clockDisplay.set12Hour(TwelveHourDisplay != 0);
+    return true;
+}
+
+static bool applyTimeDisplayFont(int32_t)
+{
+    clockDisplay.setDisplayStyle(static_cast<ClockDisplay::TimeDisplaySyle>(TimeDisplayFont));
+    return true;
+}
+
+static bool applyUseFlippedFonts(int32_t)
+{
+    clockDisplay.useFlippedFonts(UseFlippedFonts != 0);
+    return true;
+}
+
+static bool applyRainGaugeCorrect(int32_t)
+{
+    return clockDisplay.setRainGaugeCorrection(RainGaugeCorrection);
+}
+
+static bool applyMonitorRssi(int32_t v)
+{
+    packetWeather.MonitorRSSI(v != 0);
+    return true;
+}
+
+static bool applyBeginRadioSilence(int32_t)
+{
+    beginRadioSilence();
+    return true;
+}
+
+static bool applyEndRadioSilence(int32_t)
+{
+    endRadioSilence();
+    return true;
+}
+
+static bool applyCpuGovernor(int32_t)
+{
+    clockGovernor.enable(CpuGovernor != 0);
+    return true;
+}
+
+static bool applyEs100FastI2c(int32_t)
+{
+    es100Wire.setFastMode(Es100FastI2c != 0);
+    return true;
+}
+
+static bool applyRadioQuiet(int32_t)
+{   // 0 off, 1 RFM69 duty cycled, 2 RFM69 asleep while the ES100 listens
+    receptionCoordinator.setMode(static_cast<ReceptionCoordinator::Mode_t>(RadioQuiet));
+    return true;
+}
+
+static bool applyTelemetry(int32_t)
+{   // seconds between status frames to the gateway. zero for none
+    telemetry.setPeriod(TelemetrySeconds);
+    return true;
+}
+
+static bool printClock(int32_t)
+{
+    clockDisplay.printClock();
+    es100Wire.printClock();
+    return true;
+}
+
+static bool printRadio(int32_t)
+{
+    packetWeather.radioPrintRegs();
+    return true;
+}
+
+static bool printAllParameters(int32_t)
+{
+    printParameters();
+    return true;
+}
+
+static bool printCpuClock(int32_t)
+{
+    clockGovernor.printStatistics();
+    return true;
+}
+
+static bool printBoot(int32_t)
+{
+    if (!ClockPolicy_t::DIAGNOSTICS)
+        return true;
+#if USE_SERIAL
+    Serial.print(F("Boot msec after reset: setup() "));
+    Serial.print(Boot::setupBeganMsec);
+    Serial.print(F(" first frame "));
+    Serial.print(Boot::firstFrameMsec);
+    for (int i = 0; i < Boot::RUNNING; i++)
     {
-        auto c1 = *p++;
-        if (c1 == 0)
-        {
-            incoming = q;
-            return true;
-        }
-        if (islower(c1))
-            c1 = toupper(c1);
-        auto c2 = *q++;
-        if (!c2)
-            return false;
-        if (islower(c2))
-            c2 = toupper(c2);
-        if (c1 != c2)
-            return false;
+        if (i >= Boot::stage)
+            break;
+        Serial.print(' ');
+        Serial.print(Boot::STAGE_NAMES[i]);
+        Serial.print(' ');
+        Serial.print(Boot::stageDoneMsec[i]);
     }
-    return false;
-}
-
-const char * const CLOCKCOMMANDS[] =
-{
-    "ListCommands",
-    "TimeZoneOffset=",
-    "ObserveDST=",
-    "LedCurrent=",
-    "LedPWM=",
-    "DstIsInEffect=",
-    "Time=",
-    "RotateLed180=",
-    "IndoorThermometerMask=",
-    "OutdoorThermometerMask=",
-    "RaingaugeMask=",
-    "MetricUnits=",
-    "WwvbSynced=",
-    "12HourDisplay=",
-    "Es100Enable=",
-    "TimeDisplayFont=",
-    "UseFlippedFonts=",
-    "Hcms290xEnable=",
-    "TryRadioSilence=",
-    "StartupDelaySeconds=",
-    "RainGaugeCorrect=",
-    "MonitorRSSI=",
-    "BeginRadioSilence",
-    "EndRadioSilence",
-    "TransmitMessage",
-    "PrintClock",
-    "PrintRadio",
-    "PrintParameters",
-};
+    Serial.println();
+    warmStart.print();
+#endif
+    return true;
+}
 
-static bool ProcessCommand(const char *cmd, uint8_t len)
+static bool applyLoopBudget(int32_t)
 {
-    uint8_t cmdIdx = 0;
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd))
-    {
+    loopMonitor.setBudget(LoopBudgetMsec);
+    return true;
+}
+
+static bool printLatency(int32_t)
+{
+    if (ClockPolicy_t::DIAGNOSTICS)
+        loopMonitor.print();
+    return true;
+}
+
+static bool printTasks(int32_t)
+{
+    if (ClockPolicy_t::DIAGNOSTICS)
+        scheduler.print();
+    return true;
+}
+
+static bool printSpi(int32_t)
+{
+    if (ClockPolicy_t::DIAGNOSTICS)
+        SpiBus::print();
+    return true;
+}
+
+static void handleDumpLog(const char *cmd)
+{   // DumpLog [count]
+    while (isspace(*cmd))
+        cmd += 1;
+    int32_t count = *cmd ? aDecimalToInt(cmd) : EventLog::CAPACITY;
+    if (count > 0)
+        EventLog::dump(static_cast<uint16_t>(count > EventLog::CAPACITY ? EventLog::CAPACITY : count));
+}
+
+static int32_t parseLogLevel(const char *&cmd)
+{
+    EventLog::Level_t v;
+    return EventLog::levelFromChar(*cmd, v) ? v : -1;
+}
+
+static bool applyLogLevel(int32_t v)
+{   // E, W, I or D. Events less severe aren't recorded
+    EventLog::setLevel(static_cast<EventLog::Level_t>(v));
 #if USE_SERIAL
-        Serial.println("Commands:");
-        for (unsigned i = 0; i < DIM(CLOCKCOMMANDS); i++)
-        {
-            Serial.print("   ");
-            Serial.println(CLOCKCOMMANDS[i]);
-        }
+    Serial.print(F("LogLevel="));
+    Serial.println(EventLog::levelName(EventLog::level()));
 #endif
+    return true;
+}
+
+static bool printMemory(int32_t)
+{
+    if (!ClockPolicy_t::DIAGNOSTICS)
         return true;
+    // ORDER MUST MATCH enum Led_Font_enum
+    static const char * const FONT_NAMES[NUM_LED_FONTS] = { "OemFont", "SmallDigitsFont", "Digits7SegFont",
+        "OemFontFlipped", "SmallDigitsFontFlipped", "Digits7SegFontFlipped" };
+    MemoryReport::Static statics[] = {
+        { "packetWeather", &packetWeather, sizeof(packetWeather) },
+        { "sensorHistory", &sensorHistory, sizeof(sensorHistory) },
+        { "warmStart", &warmStart, sizeof(warmStart) },
+        { "EventLog", EventLog::ringAddress(), EventLog::ringBytes() },
+        { "hcms290X", &hcms290X, sizeof(hcms290X) },
+        { "clockDisplay", &clockDisplay, sizeof(clockDisplay) },
+        { "journal", &journal, sizeof(journal) },
+        { "loopMonitor", &loopMonitor, sizeof(loopMonitor) },
+        { "settings", &image, sizeof(image) },
+#if USE_SERIAL
+        { "serialCommands", &serialCommands, sizeof(serialCommands) },
+#endif
+    };
+    const uint8_t NUM_STATICS = sizeof(statics) / sizeof(statics[0]);
+    MemoryReport::Static all[NUM_STATICS + NUM_LED_FONTS];
+    memcpy(all, statics, sizeof(statics));
+    for (uint8_t i = 0; i < ClockPolicy_t::FONTS_IN_IMAGE; i++)
+    {   // the rasters are const, so they are in DTCM unless marked PROGMEM
+        const auto *f = fonts[i];
+        all[NUM_STATICS + i] = { FONT_NAMES[i], f->gCharToRasters,
+            static_cast<uint32_t>(f->gNumberOfCharacters * Raster5x7Font::RASTER_BYTES_PER_CHARACTER) };
+    }
+    MemoryReport::print(all, NUM_STATICS + ClockPolicy_t::FONTS_IN_IMAGE);
+    return true;
+}
+
+static bool printJournal(int32_t)
+{
+    journal.print();
+    return true;
+}
+
+static bool printSensors(int32_t)
+{
+    packetWeather.sensors().print();
+    return true;
+}
+
+static bool printReceiveQueue(int32_t)
+{
+    packetWeather.printReceiveQueue();
+    return true;
+}
+
+static bool printTransmit(int32_t)
+{
+    packetWeather.printTransmitQueue();
+    return true;
+}
+
+static bool printRssiSurvey(int32_t)
+{
+    packetWeather.printRssiSurvey();
+    return true;
+}
+
+static bool printWwvbStats(int32_t)
+{
+    receptionCoordinator.printStatistics();
+    es100Wire.printStatistics();
+    return true;
+}
+
+static bool listCommands(int32_t);
+
+// The parse functions read a command's argument from its text
+static int32_t parseYesNo(const char *&cmd)
+{
+    return yesNo(cmd) ? 1 : 0;
+}
+
+static int32_t parseHex(const char *&cmd)
+{
+    return static_cast<int32_t>(aHexToInt(cmd));
+}
+
+static int32_t parseTimeZone(const char *&cmd)
+{   // E, C, M or P for the US time zones, else minutes
+    switch (toupper(*cmd))
+    {
+        case 'E':
+            return -5 * 60;
+        case 'C':
+            return -6 * 60;
+        case 'M':
+            return -7 * 60;
+        case 'P':
+            return -8 * 60;
     }
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //     "TimeZoneOffset=",
+    return aDecimalToInt(cmd);
+}
+
+// The handlers are for commands that don't fit the table's columns
+static void handleWwvbSynced(const char *cmd)
+{
+    if (cmd && cmd[0])
     {
-        static const char upperMask = 'a' & ~'A';
-        const char upperFirst = *cmd | upperMask;
-        switch (upperFirst)
+        auto c = cmd[0];
+        wwvbSynced = c == 'Y' || c == 'y' || c == '1';
+        if (wwvbSynced)
         {
-            case 'e':
-                TimeZoneOffset = -5 * 60;
-                break;
-            case 'c':
-                TimeZoneOffset = -6 * 60;
-                break;
-            case 'm':
-                TimeZoneOffset = -7 * 60;
-                break;
-            case 'p':
-                TimeZoneOffset = -8 * 60;
-                break;
-            default:
-                TimeZoneOffset = static_cast<int16_t>(aDecimalToInt(cmd));
-                break;
+            auto ms = millis();
+            static_assert(sizeof(ms) == sizeof(wwvbSyncTimeMsec), "wrong timer datatype");
+            wwvbSyncTimeMsec = ms;
+        }
+        else if (c == '-')
+        {
+            cmd += 1;
+            auto nw = millis();
+            wwvbSearchStartedMsec = static_cast<unsigned long>(nw - (1000 * 60l * aDecimalToInt(cmd)));
         }
-        EEPROM.put(static_cast<uint16_t>(EepromAddresses::TIME_ZONE_OFFSET), TimeZoneOffset);
-        DEBUG_OUTPUT1("TimeZoneOffset=");
-        DEBUG_OUTPUT1(TimeZoneOffset);
-        DEBUG_OUTPUT1('\n');
-        clockDisplay.setUtcMinutesOffset(TimeZoneOffset);
-        return true;
     }
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd))    //    "ObserveDST=",
+#if USE_SERIAL
+    Serial.print("Wwvb is ");
+    if (!wwvbSynced) Serial.print("not");
+    Serial.println(" synced");
+#endif
+}
+
+static void handleTransmitMessage(const char *cmd)
+{
+    while (isspace(*cmd)) cmd += 1;
+    if (!*cmd) return;
+    int node = aDecimalToInt(cmd);
+    while (isspace(*cmd)) cmd += 1;
+    if (!*cmd) return;
+    packetWeather.SendRadioMessage(node, cmd);
+}
+
+static void handleSensor(const char *cmd)
+{   // Sensor=<node id>,<role I O R or N>[,<calibration>]
+    // calibration for thermometers is in tenths of a degree C
+    auto id = aDecimalToInt(cmd);
+    SensorRegistry::Role_t role;
+    if (id <= 0 || id >= SensorRegistry::NUM_NODE_IDS || !SensorRegistry::roleFromChar(*cmd, role))
     {
-        observeDST = static_cast<uint8_t>(aDecimalToInt(cmd));
-        EEPROM.put(static_cast<uint16_t>(EepromAddresses::OBSERVE_DST), observeDST);
-        clockDisplay.setDST(dstInEffect && observeDST);
-        dstScheduleFromWwvbToClock();
-        return true;
+#if USE_SERIAL
+        Serial.println(F("Sensor=<id>,<I|O|R|N>[,<calibration>]"));
+#endif
+        return;
     }
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //    "LedCurrent=",
+    cmd += 1;
+    int8_t cal = 0;
+    if (*cmd == ',')
     {
-        LedCurrent = 0x3u & static_cast<uint8_t>(aDecimalToInt(cmd));
-        EEPROM.put(static_cast<uint16_t>(EepromAddresses::LED_CURRENT), LedCurrent);
-        hcms290X.setLedCurrent(LedCurrent);
-        return true;
-    }    
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //     "LedPWM=",
-    {
-        LedPwm = 0xFu & static_cast<uint8_t>(aDecimalToInt(cmd));
-        EEPROM.put(static_cast<uint16_t>(EepromAddresses::LED_PWM), LedPwm);
-        hcms290X.setledPWM(LedPwm);
-        return true;
-    }    
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd))  //  "DstIsInEffect=",
+        cmd += 1;
+        cal = static_cast<int8_t>(aDecimalToInt(cmd));
+    }
+    packetWeather.sensors().setRole(static_cast<uint8_t>(id), role, cal);
+}
+
+static void handleHistory(const char *cmd)
+{   // History=<node id>[,<minutes>]
+    auto id = aDecimalToInt(cmd);
+    int32_t minutes = 60;
+    if (*cmd)
+        minutes = aDecimalToInt(cmd);
+    if (id > 0 && id < SensorRegistry::NUM_NODE_IDS && minutes > 0)
+        sensorHistory.dump(static_cast<uint8_t>(id), static_cast<uint16_t>(minutes));
+}
+
+static void handleListenMode(const char *cmd)
+{   // ListenMode=<idle msec>[,<rx usec>]   idle of zero for continuous receive
+    if (cmd && cmd[0])
     {
-        if (!cmd || !cmd[0])
+        auto idle = aDecimalToInt(cmd);
+        auto rx = *cmd ? aDecimalToInt(cmd) : LISTEN_RX_DEFAULT_USEC;
+        if (idle >= 0 && idle <= QueuedRFM69::LISTEN_IDLE_MAX_MSEC &&
+            rx > 0 && rx <= QueuedRFM69::LISTEN_RX_MAX_USEC &&
+            !QueuedRFM69::listenCovered(static_cast<uint16_t>(idle), static_cast<uint16_t>(rx)))
         {
 #if USE_SERIAL
-            Serial.print(F("Dst in effect="));
-            Serial.println(static_cast<int>(dstInEffect));
+            Serial.print(F("ListenMode refused: idle plus RX is longer than the sender preamble of "));
+            Serial.print(QueuedRFM69::SENDER_PREAMBLE_USEC);
+            Serial.println(F(" usec"));
 #endif
         }
-        else
+        else if (idle >= 0 && idle <= QueuedRFM69::LISTEN_IDLE_MAX_MSEC &&
+            rx > 0 && rx <= QueuedRFM69::LISTEN_RX_MAX_USEC)
         {
-            dstInEffect = static_cast<uint8_t>(aDecimalToInt(cmd));
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::DST_IN_EFFECT), dstInEffect);
-            clockDisplay.setDST(dstInEffect && observeDST);
+            ListenIdleMsec = static_cast<uint16_t>(idle);
+            ListenRxUsec = static_cast<uint16_t>(rx);
+            settingsStore.changed();
+            packetWeather.configureListen(ListenIdleMsec, ListenRxUsec);
         }
-        return true;
-    }  
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "Time=",
-    {
-        auto utc = static_cast<time_t>(aDecimalToInt(cmd));
-        DEBUG_OUTPUT1(F("As set:"));
-        DEBUG_OUTPUT1(utc);
-        DEBUG_OUTPUT1('\n');
-        Teensy3Clock.set(utc);
-        setTime(utc);
-        return true;
-    }  
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "RotateLed180=",
-    {
-        rotateLed180 = static_cast<uint8_t>(aDecimalToInt(cmd));
-        DEBUG_OUTPUT1(F("Rotate180 is now:"));
-        DEBUG_OUTPUT1(static_cast<unsigned>(rotateLed180));
-        DEBUG_OUTPUT1('\n');
-        EEPROM.put(static_cast<uint16_t>(EepromAddresses::ROTATE_LED_180), rotateLed180);
-        hcms290X.setRotate180(rotateLed180 != 0);
-        clockDisplay.updateDisplay();
-        return true;
-    }  
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //IndoorThermometerMask=",
+    }
+#if USE_SERIAL
+    Serial.print("ListenMode is ");
+    Serial.print(ListenIdleMsec);
+    Serial.print(',');
+    Serial.println(ListenRxUsec);
+#endif
+}
+
+/* The clock's commands, one entry each.
+** A setting names its Settings variable. Running it range checks the argument,
+** stores the variable, calls apply, then tells the SettingsStore. With no argument
+** it prints the setting. An action has no variable: apply gets the argument.
+** The commands that don't fit parse their own text in a handler.
+**
+** The entries are in case insensitive order of name, so lookup is a binary search.
+** The static_asserts below the table check that order, and that every
+** ClockCommands_t has exactly one entry.
+*/
+namespace Commands {
+    typedef int32_t (*Parse_t)(const char *&);
+    typedef bool (*Apply_t)(int32_t);
+    typedef void (*Handler_t)(const char *);
+
+    struct Entry {
+        const char *name; // ends in '=' if it takes an argument
+        ClockCommands_t id;
+        Parse_t parse; // nullptr for no argument
+        int32_t minValue;
+        int32_t maxValue;
+        void *setting;
+        uint8_t settingBytes;
+        Apply_t apply;
+        Handler_t handler;
+    };
+
+    template <typename T>
+    constexpr Entry setting(const char *name, ClockCommands_t id, Parse_t parse, int32_t minValue, int32_t maxValue,
+            T &v, Apply_t apply = nullptr)
     {
-        PacketIndoorTempIdMask = aHexToInt(cmd);
-        EEPROM.put(static_cast<uint16_t>(EepromAddresses::PACKET_INDOOR_THERMOMETER_MASK), PacketIndoorTempIdMask);
-        packetWeather.SetThermometerIdMasks(PacketIndoorTempIdMask,PacketOutdoorTempIdMask);
-        return true;
-    }  
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "OutdoorThermometerMask=",
+        return Entry{name, id, parse, minValue, maxValue, &v, sizeof(T), apply, nullptr};
+    }
+
+    constexpr Entry action(const char *name, ClockCommands_t id, Apply_t apply,
+            Parse_t parse = nullptr, int32_t minValue = INT32_MIN, int32_t maxValue = INT32_MAX)
     {
-        PacketOutdoorTempIdMask = aHexToInt(cmd);
-        EEPROM.put(static_cast<uint16_t>(EepromAddresses::PACKET_OUTDOOR_THERMOMETER_MASK), PacketOutdoorTempIdMask);
-        packetWeather.SetThermometerIdMasks(PacketIndoorTempIdMask,PacketOutdoorTempIdMask);
-        return true;
-    }  
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "RaingaugeMask=",
+        return Entry{name, id, parse, minValue, maxValue, nullptr, 0, apply, nullptr};
+    }
+
+    constexpr Entry text(const char *name, ClockCommands_t id, Handler_t handler)
     {
-        PacketRaingaugeIdMask = aHexToInt(cmd);
-        EEPROM.put(static_cast<uint16_t>(EepromAddresses::PACKET_RAINGAUGE_MASK), PacketRaingaugeIdMask);
-        packetWeather.SetRaingaugeIdMask(PacketRaingaugeIdMask);
-        return true;
-    }  
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "MetricUnits=",
+        return Entry{name, id, nullptr, 0, 0, nullptr, 0, nullptr, handler};
+    }
+
+    typedef ClockCommands_t C;
+    const int32_t DISPLAY_STYLES = static_cast<int32_t>(ClockDisplay::TimeDisplaySyle::DISPLAY_STYLE_MAX);
+
+    constexpr Entry TABLE[] =
     {
-        auto c = cmd[0];
-        bool metric = (c == 'Y' || c == 'y' || c == '1');
-        if (c != 0)
-        {
-            unitsInMetric = metric ? 1 : 0;
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::UNITS_IN_METRIC), unitsInMetric);
-            clockDisplay.unitsInMetric(unitsInMetric != 0);
-        }
-#if USE_SERIAL
-        Serial.print("unitsInMetric=");
-        Serial.println(static_cast<unsigned>(unitsInMetric));
-#endif
-        return true;
-    }  
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "WwvbSynced=",
+        setting("12HourDisplay=", C::C12HourDisplay, parseYesNo, 0, 1, TwelveHourDisplay, apply12HourDisplay),
+        action("BeginRadioSilence", C::BeginRadioSilence, applyBeginRadioSilence),
+        setting("CpuGovernor=", C::CpuGovernor, parseYesNo, 0, 1, CpuGovernor, applyCpuGovernor),
+        setting("DstIsInEffect=", C::DstIsInEffect, aDecimalToInt, 0, 1, dstInEffect, applyDstIsInEffect),
+        text("DumpLog", C::DumpLog, handleDumpLog),
+        action("EndRadioSilence", C::EndRadioSilence, applyEndRadioSilence),
+        setting("Es100Enable=", C::Es100Enable, parseYesNo, 0, 1, Es100Enable),
+        setting("Es100FastI2c=", C::Es100FastI2c, parseYesNo, 0, 1, Es100FastI2c, applyEs100FastI2c),
+        setting("Hcms290xEnable=", C::Hcms290xEnable, parseYesNo, 0, 1, Hcms290xEnable),
+        text("History=", C::History, handleHistory),
+        action("IndoorThermometerMask=", C::IndoorThermometerMask, applyIndoorThermometerMask, parseHex),
+        setting("LedCurrent=", C::LedCurrent, aDecimalToInt, 0, LED_CURRENT_MAX, LedCurrent, applyLedCurrent),
+        setting("LedPWM=", C::LedPWM, aDecimalToInt, 0, LED_PWM_MAX, LedPwm, applyLedPwm),
+        action("ListCommands", C::ListCommands, listCommands),
+        text("ListenMode=", C::ListenMode, handleListenMode),
+        action("LogLevel=", C::LogLevel, applyLogLevel, parseLogLevel, 0, EventLog::NUM_LEVELS - 1),
+        setting("LoopBudgetMsec=", C::LoopBudgetMsec, aDecimalToInt, LoopMonitor::MIN_BUDGET_MSEC, LoopMonitor::MAX_BUDGET_MSEC, LoopBudgetMsec, applyLoopBudget),
+        setting("MetricUnits=", C::MetricUnits, parseYesNo, 0, 1, unitsInMetric, applyMetricUnits),
+        action("MonitorRSSI=", C::MonitorRSSI, applyMonitorRssi, parseYesNo),
+        setting("ObserveDST=", C::ObserveDST, aDecimalToInt, 0, 1, observeDST, applyObserveDst),
+        action("OutdoorThermometerMask=", C::OutdoorThermometerMask, applyOutdoorThermometerMask, parseHex),
+        action("PrintBoot", C::PrintBoot, printBoot),
+        action("PrintClock", C::PrintClock, printClock),
+        action("PrintCpuClock", C::PrintCpuClock, printCpuClock),
+        action("PrintJournal", C::PrintJournal, printJournal),
+        action("PrintLatency", C::PrintLatency, printLatency),
+        action("PrintMemory", C::PrintMemory, printMemory),
+        action("PrintParameters", C::PrintParameters, printAllParameters),
+        action("PrintRadio", C::PrintRadio, printRadio),
+        action("PrintReceiveQueue", C::PrintReceiveQueue, printReceiveQueue),
+        action("PrintSensors", C::PrintSensors, printSensors),
+        action("PrintSpi", C::PrintSpi, printSpi),
+        action("PrintTasks", C::PrintTasks, printTasks),
+        action("PrintTransmit", C::PrintTransmit, printTransmit),
+        action("PrintWwvbStats", C::PrintWwvbStats, printWwvbStats),
+        setting("RadioQuiet=", C::RadioQuiet, aDecimalToInt, 0, ReceptionCoordinator::NUM_MODES - 1, RadioQuiet, applyRadioQuiet),
+        setting("RainGaugeCorrect=", C::RainGaugeCorrect, aDecimalToInt, RAIN_GAUGE_CORRECTION_MIN, RAIN_GAUGE_CORRECTION_MAX, RainGaugeCorrection, applyRainGaugeCorrect),
+        action("RaingaugeMask=", C::RaingaugeMask, applyRaingaugeMask, parseHex),
+        setting("RotateLed180=", C::RotateLed180, aDecimalToInt, 0, 1, rotateLed180, applyRotateLed180),
+        action("RssiSurvey", C::RssiSurvey, printRssiSurvey),
+        text("Sensor=", C::Sensor, handleSensor),
+        setting("StartupDelaySeconds=", C::StartupDelaySeconds, aDecimalToInt, 0, STARTUP_DELAY_MAX_SECONDS, StartupDelaySeconds),
+        setting("Telemetry=", C::Telemetry, aDecimalToInt, 0, 0xFFFE, TelemetrySeconds, applyTelemetry),
+        action("Time=", C::Time, applyTime, aDecimalToInt),
+        setting("TimeDisplayFont=", C::TimeDisplayFont, aDecimalToInt, 0, DISPLAY_STYLES - 1, TimeDisplayFont, applyTimeDisplayFont),
+        setting("TimeZoneOffset=", C::TimeZoneOffset, parseTimeZone, TIME_ZONE_MIN_MINUTES, TIME_ZONE_MAX_MINUTES, TimeZoneOffset, applyTimeZoneOffset),
+        text("TransmitMessage", C::TransmitMessage, handleTransmitMessage),
+        setting("TryRadioSilence=", C::TryRadioSilence, parseYesNo, 0, 1, TryRadioSilence),
+        setting("UseFlippedFonts=", C::UseFlippedFonts, parseYesNo, 0, 1, UseFlippedFonts, applyUseFlippedFonts),
+        text("WwvbSynced=", C::WwvbSynced, handleWwvbSynced),
+    };
+    const uint8_t NUM_ENTRIES = DIM(TABLE);
+    const uint8_t NUM_COMMANDS = static_cast<uint8_t>(ClockCommands_t::NUM_COMMANDS);
+
+    constexpr char upper(char c)
     {
-        if (cmd && cmd[0])
-        {
-            auto c = cmd[0];
-            wwvbSynced = c == 'Y' || c == 'y' || c == '1';
-            if (wwvbSynced)
-            {
-                auto ms = millis();
-                static_assert(sizeof(ms) == sizeof(wwvbSyncTimeMsec), "wrong timer datatype");
-                wwvbSyncTimeMsec = ms;
-            }
-            else if (c == '-')
-            {
-                cmd += 1;
-                auto nw = millis();
-                wwvbSearchStartedMsec = static_cast<unsigned long>(nw - (1000 * 60l * aDecimalToInt(cmd)));
-            }
-        }
-        {
-#if USE_SERIAL
-            Serial.print("Wwvb is ");
-            if (!wwvbSynced) Serial.print("not");
-            Serial.println(" synced");
-#endif
-        }
-        return true;
+        return c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c;
     }
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "12HourDisplay="
+
+    // compare name to the first len characters of token. negative if name sorts first
+    constexpr int compareName(const char *name, const char *token, uint8_t len)
     {
-        if (cmd && cmd[0])
-        {
-            auto c = cmd[0];
-            TwelveHourDisplay = (c == 'Y' || c == 'y' || c == '1') ? 1 : 0;
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::TWELVE_HOUR_DISPLAY), TwelveHourDisplay);
-            clockDisplay.set12Hour(TwelveHourDisplay != 0);
-        }
+        for (uint8_t i = 0; i < len; i++)
         {
-#if USE_SERIAL
-            Serial.print("TwelveHourDisplay is ");
-            Serial.println(static_cast<int>(TwelveHourDisplay));
-#endif
+            auto a = upper(name[i]);
+            auto b = upper(token[i]);
+            if (a != b || a == 0)
+                return a - b;
         }
+        return name[len];
+    }
+
+    constexpr uint8_t nameLength(const char *name)
+    {
+        uint8_t len = 0;
+        while (name[len]) len += 1;
+        return len;
+    }
+
+    constexpr bool sorted()
+    {
+        for (uint8_t i = 1; i < NUM_ENTRIES; i++)
+            if (compareName(TABLE[i - 1].name, TABLE[i].name, nameLength(TABLE[i].name)) >= 0)
+                return false;
         return true;
     }
-   
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //     "Es100Enable=",
+
+    constexpr bool eachCommandOnce()
     {
-        if (cmd && cmd[0])
+        for (uint8_t c = 0; c < NUM_COMMANDS; c++)
         {
-            auto c = cmd[0];
-            Es100Enable = (c == 'Y' || c == 'y' || c == '1') ? 1 : 0;
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::ES100_ENABLE), Es100Enable);
-        }
-        {
-#if USE_SERIAL
-            Serial.print("Es100Enable is ");
-            Serial.println(static_cast<int>(Es100Enable));
-#endif
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < NUM_ENTRIES; i++)
+                if (static_cast<uint8_t>(TABLE[i].id) == c)
+                    count += 1;
+            if (count != 1)
+                return false;
         }
         return true;
     }
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //     "TimeDisplayFont=",   
+    static_assert(sorted(), "Commands::TABLE must be in order of name");
+    static_assert(eachCommandOnce(), "Commands::TABLE needs exactly one entry per ClockCommands_t");
+
+    // where each ClockCommands_t is in TABLE
+    struct Index {
+        uint8_t pos[NUM_COMMANDS];
+    };
+    constexpr Index makeIndex()
     {
-        if (cmd && cmd[0])
+        Index ret{};
+        for (uint8_t i = 0; i < NUM_ENTRIES; i++)
+            ret.pos[static_cast<uint8_t>(TABLE[i].id)] = i;
+        return ret;
+    }
+    constexpr Index BY_ID = makeIndex();
+
+    // cmd is advanced past the name
+    const Entry *find(const char *&cmd)
+    {   // the name runs through '=', or up to white space
+        uint8_t len = 0;
+        while (cmd[len] && cmd[len] != '=' && !isspace(cmd[len]))
+            len += 1;
+        if (cmd[len] == '=')
+            len += 1;
+        int lo = 0;
+        int hi = NUM_ENTRIES - 1;
+        while (lo <= hi)
         {
-            TimeDisplayFont   = aDecimalToInt(cmd);
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::CLOCK_DISPLAY_STYLE), TimeDisplayFont);
+            int mid = (lo + hi) / 2;
+            auto c = compareName(TABLE[mid].name, cmd, len);
+            if (c == 0)
+            {
+                cmd += len;
+                return &TABLE[mid];
+            }
+            if (c < 0)
+                lo = mid + 1;
+            else
+                hi = mid - 1;
         }
-        {
-            clockDisplay.setDisplayStyle(static_cast<ClockDisplay::TimeDisplaySyle>(TimeDisplayFont));
-#if USE_SERIAL
-            Serial.print("TimeDisplayFont is ");
-            Serial.println(static_cast<int>(TimeDisplayFont));
-#endif
+        return nullptr;
+    }
+
+    int32_t value(const Entry &e)
+    {   // settings are little endian, and sign extended if they may be negative
+        int32_t v = 0;
+        memcpy(&v, e.setting, e.settingBytes);
+        if (e.minValue < 0)
+        {   // sign extend by conversion. Left shifting a negative value is undefined
+            if (e.settingBytes == sizeof(int8_t))
+                v = static_cast<int8_t>(v);
+            else if (e.settingBytes == sizeof(int16_t))
+                v = static_cast<int16_t>(v);
         }
-        return true;
-    } 
+        return v;
+    }
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //    "UseFlippedFonts=",
+    /* endBatch commits the SettingsStore if every command in the batch succeeded,
+    ** and otherwise puts back the values from before the batch. A quiet batch
+    ** leaves the report to endBatch instead of echoing each command. */
+    struct Batch {
+        bool active;
+        bool quiet;
+        uint8_t failed;
+        bool changed[NUM_COMMANDS];
+        int32_t prev[NUM_COMMANDS];
+    };
+    Batch batch;
+
+    bool apply(const Entry &e, int32_t v)
     {
-        auto c = cmd[0];
-        if (cmd && c)
+        if (e.handler || v < e.minValue || v > e.maxValue)
         {
-            UseFlippedFonts = (c == 'Y' || c == 'y' || c == '1') ? 1 : 0;
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::USE_FLIPPED_FONTS), UseFlippedFonts);
+            batch.failed += 1;
+            return false;
         }
+        if (!e.setting)
         {
-            clockDisplay.useFlippedFonts(UseFlippedFonts != 0);
-#if USE_SERIAL
-            Serial.print("UseFlippedFonts is ");
-            Serial.println(static_cast<int>(UseFlippedFonts));
-#endif
+            if (e.apply(v))
+                return true;
+            batch.failed += 1;
+            return false;
         }
-        return true;
-    } 
-
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //     "Hcms290xEnable=",
-    {
-        if (cmd && cmd[0])
+        int32_t prev = 0;
+        memcpy(&prev, e.setting, e.settingBytes);
+        memcpy(e.setting, &v, e.settingBytes);
+        if (e.apply && !e.apply(v))
         {
-            auto c = cmd[0];
-            Hcms290xEnable = (c == 'Y' || c == 'y' || c == '1') ? 1 : 0;
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::HCMS290x_ENABLE), Hcms290xEnable);
+            memcpy(e.setting, &prev, e.settingBytes);
+            batch.failed += 1;
+            return false;
         }
+        settingsStore.changed();
+        auto c = static_cast<uint8_t>(e.id);
+        if (batch.active && !batch.changed[c])
         {
-#if USE_SERIAL
-            Serial.print("Hcms290xEnable is ");
-            Serial.println(static_cast<int>(Hcms290xEnable));
-#endif
+            batch.changed[c] = true;
+            batch.prev[c] = prev;
         }
         return true;
-    } 
+    }
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //     "TryRadioSilence=",
+    void beginBatch(bool quiet)
     {
-        if (cmd && cmd[0])
-        {
-            auto c = cmd[0];
-            TryRadioSilence = (c == 'Y' || c == 'y' || c == '1') ? 1 : 0;
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::TRY_RADIO_SILENCE), TryRadioSilence);
-        }
-#if USE_SERIAL
-        Serial.print("TryRadioSilence is ");
-        Serial.println(static_cast<int>(TryRadioSilence));
-#endif
-        return true;
+        memset(&batch, 0, sizeof(batch));
+        batch.active = true;
+        batch.quiet = quiet;
+    }
+
+    bool quiet()
+    {
+        return batch.active && batch.quiet;
     }
-        
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //     "StartupDelaySeconds=",
+
+    void endBatch(uint8_t commands, uint8_t unknown)
     {
-        if (cmd && cmd[0])
+        bool quiet = batch.quiet;
+        batch.active = false;
+        bool ok = batch.failed == 0 && unknown == 0;
+        uint8_t settings = 0;
+        for (uint8_t c = 0; c < NUM_COMMANDS; c++)
         {
-            StartupDelaySeconds   = aDecimalToInt(cmd);
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::STARTUP_DELAY_SECONDS), StartupDelaySeconds);
+            if (!batch.changed[c])
+                continue;
+            const auto &e = TABLE[BY_ID.pos[c]];
+            settings += 1;
+            if (!ok)
+            {
+                memcpy(e.setting, &batch.prev[c], e.settingBytes);
+                if (e.apply)
+                    e.apply(batch.prev[c]);
+            }
         }
+        if (ok)
+            settingsStore.commit();
 #if USE_SERIAL
-        Serial.print("StartupDelaySeconds is ");
-        Serial.println(static_cast<int>(StartupDelaySeconds));
-#endif
-        return true;
-    } 
-    
-     if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) //     "RainGaugeCorrect=",
-    {
-        auto temp = static_cast<int16_t>(aDecimalToInt(cmd));
-        if (clockDisplay.setRainGaugeCorrection(temp))
+        if (quiet)
         {
-            RainGaugeCorrection = temp;
-            EEPROM.put(static_cast<uint16_t>(EepromAddresses::RAINGAUGE_CORRECTION), RainGaugeCorrection);
+            Serial.print(F("Batch of "));
+            Serial.print(commands);
+            if (ok)
+                Serial.print(F(" commands OK. Settings saved: "));
+            else
+            {
+                Serial.print(F(" commands. Failed: "));
+                Serial.print(batch.failed + unknown);
+                Serial.print(F(". Settings put back: "));
+            }
+            Serial.println(settings);
         }
-        return true;
+#endif
     }
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "MonitorRSSI=",
+    void print(const Entry &e)
     {
-        auto c = cmd[0];
-        packetWeather.MonitorRSSI((c == 'Y' || c == 'y' || c == '1') ? true : false);
-        return true;
-    }  
-    
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "BeginRadioSilence",
-    {
-        beginRadioSilence();
-        return true;
+#if USE_SERIAL
+        Serial.print(e.name);
+        Serial.println(value(e));
+#endif
     }
+}
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "EndRadioSilence",
+static bool listCommands(int32_t)
+{
+#if USE_SERIAL
+    Serial.println("Commands:");
+    for (const auto &e : Commands::TABLE)
     {
-        endRadioSilence();
-        return true;
+        Serial.print("   ");
+        Serial.println(e.name);
     }
+#endif
+    return true;
+}
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "TransmitMessage",
-    {
-        while (isspace(*cmd)) cmd += 1;
-        if (!*cmd) return true;
-        int node = aDecimalToInt(cmd);
-        while (isspace(*cmd)) cmd += 1;
-        if (!*cmd) return true;
-        packetWeather.SendRadioMessage(node, cmd);
-        return true;
-    }
+bool applyClockCommand(ClockCommands_t id, int32_t v)
+{
+    auto c = static_cast<uint8_t>(id);
+    if (c >= Commands::NUM_COMMANDS)
+        return false;
+    return Commands::apply(Commands::TABLE[Commands::BY_ID.pos[c]], v);
+}
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "PrintClock",
-    {
-        clockDisplay.printClock();
-        es100Wire.printClock();
-        return true;
-    }
+static bool applyBinaryCommand(uint8_t command, int32_t v)
+{
+    return applyClockCommand(static_cast<ClockCommands_t>(command), v);
+}
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "PrintRadio",
-    {
-        packetWeather.radioPrintRegs();
-        return true;
-    }
+#define BINARY_COMMAND(TYPE, ID) {BinaryCommand::TYPE, static_cast<uint8_t>(ClockCommands_t::ID)}
+// ORDER MUST MATCH BinaryCommand::Opcode_t
+static const BinaryCommand::Entry BINARY_COMMANDS[BinaryCommand::NUM_OPCODES] =
+{
+    {BinaryCommand::ARG_NONE, BinaryCommand::NO_COMMAND}, // OP_NONE
+    BINARY_COMMAND(ARG_I16, TimeZoneOffset),
+    BINARY_COMMAND(ARG_U8, ObserveDST),
+    BINARY_COMMAND(ARG_U8, LedCurrent),
+    BINARY_COMMAND(ARG_U8, LedPWM),
+    BINARY_COMMAND(ARG_U8, DstIsInEffect),
+    BINARY_COMMAND(ARG_U32, Time),
+    BINARY_COMMAND(ARG_U8, RotateLed180),
+    BINARY_COMMAND(ARG_U32, IndoorThermometerMask),
+    BINARY_COMMAND(ARG_U32, OutdoorThermometerMask),
+    BINARY_COMMAND(ARG_U32, RaingaugeMask),
+    BINARY_COMMAND(ARG_U8, MetricUnits),
+    BINARY_COMMAND(ARG_U8, C12HourDisplay),
+    BINARY_COMMAND(ARG_U8, Es100Enable),
+    BINARY_COMMAND(ARG_U8, TimeDisplayFont),
+    BINARY_COMMAND(ARG_U8, UseFlippedFonts),
+    BINARY_COMMAND(ARG_U8, Hcms290xEnable),
+    BINARY_COMMAND(ARG_U8, TryRadioSilence),
+    BINARY_COMMAND(ARG_U8, StartupDelaySeconds),
+    BINARY_COMMAND(ARG_I16, RainGaugeCorrect),
+    BINARY_COMMAND(ARG_NONE, BeginRadioSilence),
+    BINARY_COMMAND(ARG_NONE, EndRadioSilence),
+    BINARY_COMMAND(ARG_U8, CpuGovernor),
+    BINARY_COMMAND(ARG_U8, RadioQuiet),
+    BINARY_COMMAND(ARG_U16, Telemetry),
+};
+#undef BINARY_COMMAND
+
+uint8_t routeBinaryCommand(const uint8_t *frame, uint8_t len, uint8_t *reply, uint8_t replyMax)
+{
+    auto ret = BinaryCommand::dispatch(BINARY_COMMANDS, applyBinaryCommand, frame, len, reply, replyMax);
+    settingsStore.commit(); // one frame is one batch
+    return ret;
+}
 
-    if (compareCommand(CLOCKCOMMANDS[cmdIdx++], cmd)) // "PrintParameters",
+static bool ProcessCommand(const char *cmd, uint8_t)
+{
+    auto e = Commands::find(cmd);
+    if (!e)
+        return false;
+    if (e->handler)
+        e->handler(cmd);
+    else if (!e->parse)
+        e->apply(0);
+    else if (cmd[0] && !Commands::apply(*e, e->parse(cmd)))
     {
-        printParameters();
-        return true;
+#if USE_SERIAL
+        Serial.print(e->name);
+        Serial.print(F(" allows "));
+        Serial.print(e->minValue);
+        Serial.print(F(" to "));
+        Serial.println(e->maxValue);
+#endif
     }
-
-   return false;
+    if (e->setting && !Commands::quiet())
+        Commands::print(*e);
+    return true;
 }
 
-void routeCommand(const char *cmd, uint8_t len, uint8_t senderid, bool toMe)
+bool routeCommand(const char *cmd, uint8_t len, uint8_t senderid, bool toMe)
 {
-    bool toPrint = toMe;
+    bool quiet = Commands::quiet();
+    bool toPrint = toMe && !quiet;
+    bool processed = true;
     if (packetWeather.ProcessCommand(cmd, len, senderid, toMe))
     {   
-        toPrint = true;
+        toPrint = !quiet;
 #if USE_SERIAL
-        Serial.println(F("Command accepted for radio"));
+        if (!quiet)
+            Serial.println(F("Command accepted for radio"));
 #endif
     }
     else if (toMe && ProcessCommand(cmd, len))
+    {
 #if USE_SERIAL
-        Serial.println(F("Command accepted for clock"))
+        if (!quiet)
+            Serial.println(F("Command accepted for clock"));
 #endif
-        ;
+    }
     else if (toMe)
+    {
+        processed = false;
 #if USE_SERIAL
-        Serial.println(F("command not processed"))
+        Serial.println(F("command not processed"));
 #endif
-    ;
+    }
 #if USE_SERIAL
     if (toPrint)
     {
@@ -804,110 +1551,272 @@ void routeCommand(const char *cmd, uint8_t len, uint8_t senderid, bool toMe)
             Serial.println();
     }
 #endif
+    return processed;
 }
 
-void loop()
+/* A line from Serial may hold several commands separated by ';'.
+** They run as one batch, so a clock can be provisioned by pasting one line.
+** If any command fails, the settings go back to what they were. The batch is
+** not atomic for anything else: actions, Time= among them, take effect as they
+** run and are not undone, and DstIsInEffect= writes the journal at once, and
+** again when it is put back. */
+static void runCommandLine(char *line)
 {
-    auto nowMillis = millis();
-    bool sw1 = digitalRead(SW1_INPUT_PIN) == LOW;
-    bool sw2 = digitalRead(SW2_INPUT_PIN) == LOW;  
-    
-    if (wwvbSynced)
-    {   // resync with WWVB after T1_Hour
-        if (static_cast<int32_t>(nowMillis - wwvbSyncTimeMsec) > T1_Hour_msec)
+    uint8_t commands = 0;
+    uint8_t unknown = 0;
+    Commands::beginBatch(strchr(line, ';') != nullptr);
+    for (char *cmd = line; cmd; )
+    {
+        char *next = strchr(cmd, ';');
+        if (next)
+            *next++ = 0;
+        while (isspace(*cmd))
+            cmd += 1;
+        auto len = strlen(cmd);
+        while (len > 0 && isspace(cmd[len - 1]))
+            cmd[--len] = 0;
+        if (len > 0)
         {
-            wwvbSynced = false;
-            wwvbSearchStartedMsec = nowMillis;
+            commands += 1;
+            if (!routeCommand(cmd, static_cast<uint8_t>(len > 255 ? 255 : len)))
+                unknown += 1;
+        }
+        cmd = next;
+    }
+    Commands::endBatch(commands, unknown);
+}
+
+static void sendTelemetry()
+{
+    TelemetryFrame::Status status;
+    status.firmwareMajor = WWVBCLOCK_VERSION_MAJOR;
+    status.firmwareMinor = WWVBCLOCK_VERSION_MINOR;
+    auto searches = receptionCoordinator.searches();
+    auto syncs = receptionCoordinator.successes();
+    status.searches = searches > 0xFFFFu ? 0xFFFFu : static_cast<uint16_t>(searches);
+    status.syncs = syncs > 0xFFFFu ? 0xFFFFu : static_cast<uint16_t>(syncs);
+    status.rxDropped = packetWeather.droppedFrames();
+    status.noiseFloorDbm = static_cast<int8_t>(packetWeather.noiseFloor());
+    telemetry.fill(status);
+    uint8_t frame[TelemetryFrame::FRAME_BYTES];
+    auto len = TelemetryFrame::encode(status, frame);
+    packetWeather.sendTelemetry(frame, len);
+}
+
+static bool bootStages()
+{   // one stage per loop() so the displays keep running in between. Returns true once all are done
+    using namespace Boot;
+    if (stage == RUNNING)
+        return true;
+    auto now = millis();
+    switch (stage)
+    {
+        case STARTUP_DELAY:
+            if (!warm && now - stageBeganMsec < 1000ul * StartupDelaySeconds)
+                return false;
+            break;
+        case RADIO:
+            packetWeather.setup();
+            packetWeather.configureListen(ListenIdleMsec, ListenRxUsec);
+            break;
+        case ES100:
+            es100Wire.setFastMode(Es100FastI2c != 0);
+            es100Wire.setup(Es100Enable);  
+            if (!warm)
+                wwvbSearchStartedMsec = millis();
+            break;
+        case REPORT:
 #if USE_SERIAL
-            Serial.println(F("Beginning search for WWVB signal."));
+            if (now - setupBeganMsec < SERIAL_SETTLE_MSEC)
+                return false;
+            Serial.println("Wwvb Clock version " WWVBCLOCK_VERSION);
+            printParameters();
+            packetWeather.radioPrintInfo();
+            DEBUG_OUTPUT1(F("Teensy time now:"));
+            DEBUG_OUTPUT1(Teensy3Clock.get());
+            DEBUG_OUTPUT1('\n');
+            Serial.print(F("Journal keys recovered: "));
+            Serial.println(journalKeys);
+            warmStart.print();
+            if (ClockPolicy_t::DIAGNOSTICS)
+                loopMonitor.print();
 #endif
-        }
+            break;
+        default:
+            break;
     }
-    else if (static_cast<int32_t>(nowMillis - wwvbSearchStartedMsec) > T23_HOURS_msec)
-    {   // 23 hour timeout leaves 60 minutes of yesterday's successful hour available now
-        if (TryRadioSilence)
-        {
-            static unsigned long swDisplayStartTimeMsec = 0;
-            static_assert(sizeof(swDisplayStartTimeMsec) == sizeof(nowMillis), "Wrong time type");
-            // been searching for 24 hours
-            if (sw1 || sw2)
-            {
-                if (static_cast<int32_t>(nowMillis - swDisplayStartTimeMsec) > 5000) // 5 second debounce
+    stageDoneMsec[stage] = millis();
+    stage = static_cast<Stage_t>(stage + 1);
+    stageBeganMsec = millis();
+    if (stage == RUNNING)
+    {
+        loopMonitor.setBudget(LoopBudgetMsec);
+        printBoot(0);
 #if USE_SERIAL
-                    Serial.println(F("Switch override radio silence"))
+        Serial.println(F("setup() complete"));
 #endif
-                    ;
-                swDisplayStartTimeMsec = nowMillis;
-                endRadioSilence();
-            } else if (static_cast<int32_t>(nowMillis - swDisplayStartTimeMsec) > T30_seconds_msec)
-            {
-                if (swDisplayStartTimeMsec > 0)
+    }
+    return stage == RUNNING;
+}
+
+namespace {
+    bool wwvbReceived; // from runWwvb to runPower
+
+    bool radioPending() { return packetWeather.pending(); }
+    bool es100Pending() { return Es100Enable && es100Wire.isListening() && Es100Wire::pending(); }
+    bool buttonsPending() { return buttons.pending(); }
+    bool serialPending()
+    {
 #if USE_SERIAL
-                    Serial.println(F("Resuming radio silence."))
+        return Serial.available() > 0;
+#else
+        return false;
 #endif
-                    ;
-                swDisplayStartTimeMsec = 0;
-                beginRadioSilence();
+    }
+
+    bool runRadio()
+    {
+        packetWeather.loop();
+        return false;
+    }
+
+    bool runWwvb()
+    {
+        auto nowMillis = millis();
+        if (wwvbSynced)
+        {   // resync with WWVB after T1_Hour
+            if (static_cast<int32_t>(nowMillis - wwvbSyncTimeMsec) > T1_Hour_msec)
+            {
+                wwvbSynced = false;
+                wwvbSearchStartedMsec = nowMillis;
+                EventLog::log(EventLog::WWVB_SEARCH);
+            }
+        }
+        else if (static_cast<int32_t>(nowMillis - wwvbSearchStartedMsec) > T23_HOURS_msec)
+        {   // 23 hour timeout leaves 60 minutes of yesterday's successful hour available now
+            if (TryRadioSilence)
+            {
+                static unsigned long swDisplayStartTimeMsec = 0;
+                static_assert(sizeof(swDisplayStartTimeMsec) == sizeof(nowMillis), "Wrong time type");
+                // been searching for 24 hours
+                if (buttons.pressed(Buttons::SW1) || buttons.pressed(Buttons::SW2))
+                {   // endRadioSilence() logs the change
+                    swDisplayStartTimeMsec = nowMillis;
+                    endRadioSilence();
+                } else if (static_cast<int32_t>(nowMillis - swDisplayStartTimeMsec) > T30_seconds_msec)
+                {
+                    swDisplayStartTimeMsec = 0;
+                    beginRadioSilence();
+                }
             }
         }
-    }
 
-    if (Es100Enable && es100Wire.loop(wwvbSynced))
-    {   // read es100 time and setTeensy3Time to match, if needed
-        auto utc = es100Wire.getUTCandClear();
-        Teensy3Clock.set(utc);
-        setTime(utc);
-        wwvbSynced = true;
-        wwvbSyncTimeMsec = millis();
-        endRadioSilence();
-        auto dst = es100Wire.isDstNow();
-        if (dst >= 0)
-        {
-            if (dstInEffect != dst)
+        if (Es100Enable && es100Wire.loop(wwvbSynced))
+        {   // read es100 time and setTeensy3Time to match, if needed
+            auto utc = es100Wire.getUTCandClear();
+            auto rtcBefore = Teensy3Clock.get();
+            EventLog::log(EventLog::WWVB_SYNC, static_cast<int32_t>(utc), static_cast<int32_t>(rtcBefore - utc));
+            telemetry.noteSync(rtcBefore, utc);
+            journal.write(Journal::LAST_SYNC_UTC, static_cast<int32_t>(utc));
+            journal.write(Journal::DRIFT_ERROR_SECONDS, telemetry.driftErrorSeconds());
+            journal.write(Journal::DRIFT_INTERVAL_SECONDS, static_cast<int32_t>(telemetry.driftIntervalSeconds()));
+            Teensy3Clock.set(utc);
+            setTime(utc);
+            wwvbSynced = true;
+            wwvbSyncTimeMsec = millis();
+            endRadioSilence();
+            auto dst = es100Wire.isDstNow();
+            if (dst >= 0)
             {
-                dstInEffect = static_cast<uint8_t>(dst);
-                EEPROM.put(static_cast<uint16_t>(EepromAddresses::DST_IN_EFFECT), dstInEffect);
-                clockDisplay.setDST((dstInEffect!=0) && observeDST);
+                if (dstInEffect != dst)
+                {
+                    dstInEffect = static_cast<uint8_t>(dst);
+                    journal.write(Journal::DST_IN_EFFECT, dstInEffect);
+                    clockDisplay.setDST((dstInEffect!=0) && observeDST);
+                }
             }
+            dstScheduleFromWwvbToClock();
+            clockSettings.es100UpdatedAt(utc);
+            wwvbReceived = true;
+            scheduler.wake(TASK_POWER);
+            scheduler.wake(TASK_DISPLAY);
         }
-        dstScheduleFromWwvbToClock();
-        clockSettings.es100UpdatedAt(utc);
-#if USE_SERIAL
-        Serial.println(F("Successful reception of WWVB BPSK signal"));
-#endif
+        return false;
     }
 
-    hcms290X.loop();
- 
-    packetWeather.loop();
-
-    /* this arrangement makes clockDisplay run in the loop before
-    ** clockSettings, such that clockSettings can update the
-    ** clockDisplay after the time is on the LCD */
-    static bool lcdEnable = true;
-    clockDisplay.loop(true, lcdEnable);
-    lcdEnable = !clockSettings.loop(sw1, sw2);
+    bool runPower()
+    {   // who may run while the ES100 listens, and how fast
+        bool es100Listening = Es100Enable && es100Wire.isListening();
+        receptionCoordinator.loop(es100Listening, wwvbReceived);
+        wwvbReceived = false;
+        packetWeather.setAwake(receptionCoordinator.radioAwake());
+        clockDisplay.setQuiet(receptionCoordinator.displaysQuiet());
+        clockGovernor.loop(es100Listening);
+        return false;
+    }
 
-#if USE_SERIAL
-    while (Serial.available())
+    bool runSerial()
     {
-        static  unsigned char charsInBuf;
-        auto c = Serial.read();
-        if (c < 0)
-            break;
-        auto ch = static_cast<char>(c);
-        bool isRet = ch == '\n' || ch == '\r';
-        if (!isRet)
-            cmdbuf[charsInBuf++] = ch;
-        cmdbuf[charsInBuf] = 0;
-        if (isRet || charsInBuf >= CMD_BUFLEN - 1)
+#if USE_SERIAL
+        if (Serial.available())
+            clockGovernor.burst();
+        if (char *line = serialCommands.loop())
         {
-            routeCommand(cmdbuf, charsInBuf);
+            runCommandLine(line);
             Serial.println(F("ready>"));
-            charsInBuf = 0;
         }
-    }
 #endif
+        EventLog::loop();
+        return false;
+    }
+
+    bool runDisplay()
+    {
+        /* this arrangement makes clockDisplay run before
+        ** clockSettings, such that clockSettings can update the
+        ** clockDisplay after the time is on the LCD */
+        static bool lcdEnable = true;
+        hcms290X.loop();
+        if (clockDisplay.loop(true, lcdEnable))
+            return true; // yield between the LCD lines, for the radio
+        lcdEnable = !clockSettings.loop();
+        return false;
+    }
+
+    bool runHousekeeping()
+    {
+        auto nowMillis = millis();
+        if (telemetry.due(nowMillis))
+            sendTelemetry();
+        sensorHistory.loop(packetWeather.sensors());
+        journalRain();
+        settingsStore.loop();
+        if (warmStart.due(nowMillis))
+            saveWarmState();
+        return false;
+    }
+}
+
+void loop()
+{
+    if (!bootStages())
+    {   // radio and ES100 not started yet. Keep the time on the displays meanwhile
+        hcms290X.loop();
+        while (clockDisplay.loop(true, true));
+        return;
+    }
+    auto nowMillis = millis();
+    static auto prevLoopMillis = nowMillis;
+    telemetry.noteLoop(nowMillis - prevLoopMillis);
+    prevLoopMillis = nowMillis;
+    loopMonitor.beginLoop();
+    scheduler.loop();
+    loopMonitor.endLoop();
+}
+
+void requestCpuBurst()
+{
+    clockGovernor.burst();
 }
 
 int32_t aDecimalToInt(const char*& p)
@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <string.h>
+#include <Wire.h>
+#include "WarmStart.h"
+#include "Crc16.h"
+#include "NoInit.h"
+#include "WwvbClockDefinitions.h"
+
+namespace {
+    struct Header {
+        uint32_t savedUtc;
+        unsigned long savedMsec;
+        uint16_t warmRestarts; // since the last power up
+        uint16_t rejected;     // snapshot found, but the RTC disagreed with it
+        uint16_t stateCrc;
+        uint16_t crc;          // over the members above
+    };
+    struct Snapshot {
+        Header header;
+        WarmStart::State state;
+    };
+    // a different build with a different State must not take this one's snapshot
+    const uint32_t MAGIC = 0x57A40000ul ^ sizeof(WarmStart::State);
+
+    DMAMEM NoInit<Snapshot, MAGIC> noInitSnapshot;
+    Snapshot &snapshot = noInitSnapshot.data;
+
+    // ORDER MUST MATCH WarmStart::Start_t
+    const char * const START_NAMES[] = { "cold", "warm", "rejected" };
+
+    uint16_t headerCrc(const Header &h)
+    {
+        return crc16(&h, offsetof(Header, crc));
+    }
+}
+
+WarmStart::WarmStart()
+    : m_start(COLD)
+    , m_prevSaveMsec(0)
+    , m_rebaseMsec(0)
+    , m_saves(0)
+    , m_stateWrites(0)
+    , m_staging()
+{}
+
+WarmStart::Start_t WarmStart::setup()
+{
+    auto &h = snapshot.header;
+    if (!noInitSnapshot.valid() || h.crc != headerCrc(h))
+    {   // power up, or another build
+        memset(&h, 0, sizeof(h));
+        m_start = COLD;
+    }
+    else
+    {
+        uint32_t rtc = Teensy3Clock.get();
+        if (crc16(&snapshot.state, sizeof(snapshot.state)) == h.stateCrc &&
+            rtc >= h.savedUtc && rtc - h.savedUtc <= MAX_RESTART_SECONDS)
+        {
+            m_staging = snapshot.state;
+            m_rebaseMsec = millis() - h.savedMsec - 1000ul * (rtc - h.savedUtc);
+            h.warmRestarts += 1;
+            m_start = WARM;
+        }
+        else
+        {
+            h.rejected += 1;
+            m_start = REJECTED;
+        }
+    }
+    h.stateCrc = ~crc16(&snapshot.state, sizeof(snapshot.state)); // nothing valid until save()
+    h.crc = headerCrc(h);
+    noInitSnapshot.flush(h);
+    noInitSnapshot.claim();
+    return m_start;
+}
+
+unsigned long WarmStart::rebase(unsigned long savedMsec) const
+{
+    return savedMsec == 0 ? 0 : savedMsec + m_rebaseMsec;
+}
+
+bool WarmStart::due(unsigned long now)
+{
+    if (m_saves != 0 && now - m_prevSaveMsec < SAVE_MSEC)
+        return false;
+    m_prevSaveMsec = now;
+    return true;
+}
+
+void WarmStart::save()
+{
+    auto &h = snapshot.header;
+    if (m_saves == 0 || memcmp(&snapshot.state, &m_staging, sizeof(m_staging)) != 0)
+    {
+        snapshot.state = m_staging;
+        h.stateCrc = crc16(&snapshot.state, sizeof(snapshot.state));
+        noInitSnapshot.flush(snapshot.state);
+        m_stateWrites += 1;
+    }
+    h.savedUtc = Teensy3Clock.get();
+    h.savedMsec = millis();
+    h.crc = headerCrc(h);
+    noInitSnapshot.flush(h);
+    m_saves += 1;
+}
+
+void WarmStart::print() const
+{
+#if USE_SERIAL
+    Serial.print(F("WarmStart this boot: "));
+    Serial.print(START_NAMES[m_start]);
+    Serial.print(F(". Since power up warm="));
+    Serial.print(snapshot.header.warmRestarts);
+    Serial.print(F(" rejected="));
+    Serial.print(snapshot.header.rejected);
+    Serial.print(F(". saves="));
+    Serial.print(m_saves);
+    Serial.print(F(" state writes="));
+    Serial.println(m_stateWrites);
+#endif
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <TimeLib.h>
+#include "SensorRegistry.h"
+#include "Es100Wire.h"
+
+/* WarmStart keeps a snapshot of runtime state in RAM that the startup code doesn't
+** clear, so that a watchdog or software reset resumes where the clock left off
+** instead of beginning a fresh WWVB search. A power cycle loses it, which is what
+** the Journal is for.
+**
+** The snapshot is two parts, each with its own CRC:
+**      header  when it was last saved, by the RTC and by millis(), and the restart counts.
+**              Rewritten on every save, which is cheap.
+**      State   everything else. Times in it are millis() values, which don't change
+**              while nothing happens, so it is rewritten and its CRC recalculated only
+**              when something does. Its millis() values are rebased on restore.
+** The snapshot is trusted only if both CRCs check and the RTC has advanced less than
+** MAX_RESTART_SECONDS since it was saved.
+*/
+class WarmStart {
+    public:
+        static const unsigned long SAVE_MSEC = 1000;
+        static const uint32_t MAX_RESTART_SECONDS = 120;
+
+        struct State {
+            unsigned long wwvbSyncTimeMsec;
+            unsigned long wwvbSearchStartedMsec;
+            time_t dstChangesWhen;
+            float rainToday;
+            float rainYesterday;
+            Es100Wire::DstStatus es100;
+            uint8_t wwvbSynced;
+            uint8_t dstInEffect;
+            uint8_t dst;
+            uint8_t dstScheduledBegin;
+            SensorRegistry::Entry sensors[SensorRegistry::NUM_NODE_IDS];
+        };
+
+        enum Start_t {COLD, WARM, REJECTED};
+
+        WarmStart();
+        // call once at boot, before anything is saved. On WARM, restored() holds the snapshot
+        Start_t setup();
+        const State &restored() const { return m_staging; }
+        // millis() value saved in the snapshot, translated to this boot. Zero stays zero
+        unsigned long rebase(unsigned long savedMsec) const;
+
+        // when due(), fill staging() and save()
+        bool due(unsigned long now);
+        State &staging() { return m_staging; }
+        void save();
+
+        void print() const;
+
+    protected:
+        Start_t m_start;
+        unsigned long m_prevSaveMsec;
+        unsigned long m_rebaseMsec; // add to a saved millis() to get this boot's
+        uint32_t m_saves;
+        uint32_t m_stateWrites;
+        State m_staging;
+};
@@ -10,6 +10,35 @@ Definition for the hardware LED variations:
 //#define DEBUG_TO_SERIAL
 #define FLIPPED_LED_UPDOWN 0
 #define DUAL_ROW_LED_DISPLAY 0
+#define FLIPPED_LED_FONTS 1 // 0 leaves the flipped rasters out. UseFlippedFonts= then does nothing
+#define CLOCK_DIAGNOSTICS 1 // 0 leaves out the latency, task, SPI, memory and boot reports
+/* The preamble, in bytes, of the slowest-to-repeat sensor. The RFM69 library default is 3.
+** ListenMode can only catch a packet whose preamble spans the listen idle plus RX window,
+** at least 4.1 msec, so it is refused unless senders are set up with a long preamble,
+** or burst their packets for that long. Count a burst here in byte times. */
+#define LISTEN_SENDER_PREAMBLE_BYTES 3
+/* ClockPolicy.h turns these into the ClockPolicy_t the sketch uses.
+**
+** What each choice adds, in bytes. The font rasters are const tables not marked
+** PROGMEM, so they are in the flash image and copied to DTCM at boot. Each Raster5x7Font is 12 bytes more.
+**      FLIPPED_LED_FONTS 1     flash and DTCM: OEM 475, small digits 250, 7 segment 50. 775 total + 36
+**      DUAL_ROW_LED_DISPLAY 1  DTCM: 20 more bytes in the static raster buffer of displayString()
+**      USE_SERIAL 0            everything printed, the command line and its reader. serialCommands is 280 bytes of DTCM
+**      CLOCK_DIAGNOSTICS 0     code and strings of LoopMonitor::print, Scheduler::print,
+**                              SpiBus::print, MemoryReport::print and printBoot. Not measured
+** The whole image's flash and RAM depend on the Teensyduino and library versions,
+** so measure them from the build, once per configuration:
+**  1. set the four defines above, and in the Arduino IDE turn on
+**     File/Preferences/Show verbose output during compilation
+**  2. Sketch/Verify. The last lines of the output are teensy_size's report of
+**     FLASH code, data and headers, and RAM1 and RAM2 use, for this configuration
+**  3. or, from the build directory the verbose output names:
+**        arm-none-eabi-size -A WWVBclock.ino.elf
+**     .text.progmem and .text.itcm are flash code, .data is DTCM copied from flash,
+**     .bss and .bss.dma are RAM1 and RAM2
+** The PrintMemory command can't do this. It reports the running clock's stack and
+** heap, and prints nothing with CLOCK_DIAGNOSTICS 0 or USE_SERIAL 0.
+*/
 #if defined(DEBUG_TO_SERIAL) && (USE_SERIAL > 0)
 #define DEBUG_OUTPUT1(a) Serial.print(a)
 #define DEBUG_OUTPUT2(a, b) Serial.print(a,b)